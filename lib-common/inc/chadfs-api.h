@@ -0,0 +1,362 @@
+/*
+	Per-width API, included by chadfs.h once for CHADFS(32) and once for
+	CHADFS(64) (names are expanded with CHADFS_W, see chadfs-tmpl.h)
+*/
+/* ================================================= */
+	bool CHADFS_N(check_mblk)(
+		CHADFS_T(mblk)* mblk
+	);
+
+	chadfs_status_t CHADFS_N(init_mblk)(
+		CHADFS_T(mblk)* mblk,
+		uint32_t sectorsize
+	);
+	
+	chadfs_status_t CHADFS_N(init_vblk)(
+		CHADFS_T(vblk)* vblk,
+		const chadfs_sv_t* sname,
+		CHADFS_UINT numiblks,
+		uint32_t clustersize
+	);
+	
+	chadfs_status_t CHADFS_N(init_fblk)(
+		CHADFS_B(fblk)* fblk,
+		const chadfs_sv_t* sname,
+		CHADFS_UINT size
+	);
+/* ================================================= */
+	chadfs_status_t CHADFS_N(find_free_fblk)(
+		void* dev,
+		const CHADFS_T(loc)* vblkloc,
+		CHADFS_T(eloc)* iblkeloc
+	);
+
+	chadfs_status_t CHADFS_N(find_free_dblk)(
+		void* dev,
+		const CHADFS_T(loc)* vblkloc,
+		CHADFS_T(eloc)* iblkeloc
+	);
+
+	chadfs_status_t CHADFS_N(find_next_free_dblk)(
+		void* dev,
+		const CHADFS_T(loc)* vblkloc,
+		CHADFS_UINT iprev,
+		CHADFS_T(eloc)* iblkeloc
+	);
+/* ================================================= */
+	chadfs_status_t CHADFS_N(read_mblk)(
+		void* dev,
+		CHADFS_UINT address,
+		CHADFS_T(mblk)* mblk
+	);
+
+	chadfs_status_t CHADFS_N(read_vblk)(
+		void* dev,
+		const CHADFS_T(loc)* mblkloc,
+		const chadfs_sv_t* sname,
+		CHADFS_B(vblk)* vblk,
+		CHADFS_T(eloc)* vblkeloc
+	);
+
+	chadfs_status_t CHADFS_N(read_fblk)(
+		void* dev, 
+		const CHADFS_T(loc)* mblkloc,
+		const chadfs_sv_t* spath,
+		CHADFS_B(fblk)* fblk,
+		CHADFS_T(eloc)* fblkeloc,
+		CHADFS_B(vblk)* vblk,
+		CHADFS_T(eloc)* vblkeloc
+	);
+/* ================================================= */
+	chadfs_status_t CHADFS_N(write_data)(
+		void* dev,
+		const CHADFS_T(loc)* vblkloc,
+		const void* data,
+		CHADFS_UINT len,
+		CHADFS_T(eloc)* firstieloc,
+		CHADFS_T(eloc)* lastieloc
+	);
+
+	chadfs_status_t CHADFS_N(read_data)(
+		void* dev,
+		const CHADFS_T(loc)* vblkloc,
+		CHADFS_UINT ifirstidblk,
+		void* buffer,
+		CHADFS_UINT offset,
+		CHADFS_UINT len
+	);
+
+	chadfs_status_t CHADFS_N(cut_data)(
+		void* dev,
+		const CHADFS_T(loc)* vblkloc,
+		CHADFS_UINT ifirstidblk,
+		CHADFS_UINT offset,
+		CHADFS_T(eloc)* lastidblkeloc
+	);
+/* ================================================= */
+	chadfs_status_t CHADFS_N(create_file)(
+		void* dev,
+		const CHADFS_T(loc)* mblkloc,
+		const chadfs_sv_t* spath,
+		uint32_t attributes,
+		const void* data,
+		CHADFS_UINT len
+	);
+
+	chadfs_status_t CHADFS_N(create_dir)(
+		void* dev,
+		const CHADFS_T(loc)* mblkloc,
+		const chadfs_sv_t* spath,
+		uint32_t attributes
+	);
+
+	chadfs_status_t CHADFS_N(read_file)(
+		void* dev,
+		const CHADFS_T(loc)* mblkloc,
+		const chadfs_sv_t* spath,
+		void* buffer,
+		CHADFS_UINT offset,
+		CHADFS_UINT len
+	);
+
+	chadfs_status_t CHADFS_N(append_file)(
+		void* dev,
+		const CHADFS_T(loc)* mblkloc,
+		const chadfs_sv_t* spath,
+		const void* data,
+		CHADFS_UINT len
+	);
+
+	chadfs_status_t CHADFS_N(trunc_file)(
+		void* dev,
+		const CHADFS_T(loc)* mblkloc,
+		const chadfs_sv_t* spath,
+		CHADFS_UINT len
+	);
+
+	chadfs_status_t CHADFS_N(remove_file)(
+		void* dev,
+		const CHADFS_T(loc)* mblkloc,
+		const chadfs_sv_t* spath
+	);
+
+	chadfs_status_t CHADFS_N(rename_file)(
+		void* dev,
+		const CHADFS_T(loc)* mblkloc,
+		const chadfs_sv_t* soldpath,
+		const chadfs_sv_t* snewpath
+	);
+
+	chadfs_status_t CHADFS_N(remove_tree)(
+		void* dev,
+		const CHADFS_T(loc)* mblkloc,
+		const chadfs_sv_t* spath
+	);
+
+	chadfs_status_t CHADFS_N(write_file)(
+		void* dev,
+		const CHADFS_T(loc)* mblkloc,
+		const chadfs_sv_t* spath,
+		const void* data,
+		CHADFS_UINT offset,
+		CHADFS_UINT len
+	);
+
+	chadfs_status_t CHADFS_N(punch_hole)(
+		void* dev,
+		const CHADFS_T(loc)* mblkloc,
+		const chadfs_sv_t* spath,
+		CHADFS_UINT offset,
+		CHADFS_UINT len
+	);
+
+	chadfs_status_t CHADFS_N(prealloc_file)(
+		void* dev,
+		const CHADFS_T(loc)* mblkloc,
+		const chadfs_sv_t* spath,
+		CHADFS_UINT len
+	);
+
+	chadfs_status_t CHADFS_N(share_file)(
+		void* dev,
+		const CHADFS_T(loc)* mblkloc,
+		const chadfs_sv_t* ssrcpath,
+		const chadfs_sv_t* sdstpath
+	);
+
+	chadfs_status_t CHADFS_N(reclaim)(
+		void* dev,
+		const CHADFS_T(loc)* mblkloc,
+		const chadfs_sv_t* sname,
+		CHADFS_UINT budget,
+		CHADFS_UINT* numleft
+	);
+/* ================================================= */
+	chadfs_status_t CHADFS_N(add_volume)(
+		void* dev,
+		const CHADFS_T(loc)* mblkloc,
+		const CHADFS_B(vblk)* vblk
+	);
+/* ================================================= */
+	chadfs_status_t CHADFS_N(create_iter)(
+		void* dev,
+		const CHADFS_T(loc)* mblkloc,
+		const chadfs_sv_t* spath,
+		CHADFS_T(dirit)* iter,
+		CHADFS_B(fblk)* firstfblk
+	);
+
+	chadfs_status_t CHADFS_N(move_iter)(
+		void* dev,
+		CHADFS_T(dirit)* iter,
+		CHADFS_B(fblk)* fblk
+	);
+/* ================================================= */
+	chadfs_status_t CHADFS_N(open_reader)(
+		void* dev,
+		const CHADFS_T(loc)* vblkloc,
+		CHADFS_UINT ifirstidblk,
+		CHADFS_UINT offset,
+		CHADFS_UINT len,
+		CHADFS_T(reader)* reader
+	);
+
+	chadfs_status_t CHADFS_N(open_file_reader)(
+		void* dev,
+		const CHADFS_T(loc)* mblkloc,
+		const chadfs_sv_t* spath,
+		CHADFS_UINT offset,
+		CHADFS_T(reader)* reader
+	);
+
+	chadfs_status_t CHADFS_N(read_chunk)(
+		void* dev,
+		CHADFS_T(reader)* reader,
+		void* buffer,
+		CHADFS_UINT* len
+	);
+
+	chadfs_status_t CHADFS_N(open_writer)(
+		void* dev,
+		const CHADFS_T(loc)* mblkloc,
+		const chadfs_sv_t* spath,
+		CHADFS_T(writer)* writer
+	);
+
+	chadfs_status_t CHADFS_N(write_chunk)(
+		void* dev,
+		CHADFS_T(writer)* writer,
+		const void* data,
+		CHADFS_UINT len
+	);
+
+	chadfs_status_t CHADFS_N(open_delayed_writer)(
+		void* dev,
+		const CHADFS_T(loc)* mblkloc,
+		const chadfs_sv_t* spath,
+		void* buffer,
+		size_t size,
+		CHADFS_T(writer)* writer
+	);
+
+	chadfs_status_t CHADFS_N(flush_writer)(
+		void* dev,
+		CHADFS_T(writer)* writer
+	);
+
+	chadfs_status_t CHADFS_N(close_writer)(
+		void* dev,
+		CHADFS_T(writer)* writer
+	);
+
+	chadfs_status_t CHADFS_N(copy_file)(
+		void* dev,
+		const CHADFS_T(loc)* mblkloc,
+		const chadfs_sv_t* ssrcpath,
+		const chadfs_sv_t* sdstpath,
+		bool share,
+		CHADFS_T(copier)* copier
+	);
+/* ================================================= */
+	chadfs_status_t CHADFS_N(replay_journals)(
+		void* dev,
+		const CHADFS_T(loc)* mblkloc
+	);
+
+	chadfs_status_t CHADFS_N(begin_journal)(
+		void* dev,
+		const CHADFS_T(loc)* vblkloc,
+		void* buffer,
+		size_t size,
+		chadfs_journal_t* journal
+	);
+
+	chadfs_status_t CHADFS_N(commit_journal)(
+		chadfs_journal_t* journal
+	);
+
+	chadfs_status_t CHADFS_N(end_journal)(
+		chadfs_journal_t* journal
+	);
+/* ================================================= */
+	void CHADFS_N(init_batch)(
+		CHADFS_T(batch)* batch,
+		CHADFS_T(bop)* ops,
+		uint32_t numops,
+		void* buffer,
+		size_t size
+	);
+
+	chadfs_status_t CHADFS_N(batch_create_file)(
+		CHADFS_T(batch)* batch,
+		const chadfs_sv_t* spath,
+		uint32_t attributes,
+		const void* data,
+		CHADFS_UINT len
+	);
+
+	chadfs_status_t CHADFS_N(batch_create_dir)(
+		CHADFS_T(batch)* batch,
+		const chadfs_sv_t* spath,
+		uint32_t attributes
+	);
+
+	chadfs_status_t CHADFS_N(batch_remove_file)(
+		CHADFS_T(batch)* batch,
+		const chadfs_sv_t* spath
+	);
+
+	chadfs_status_t CHADFS_N(batch_write_file)(
+		CHADFS_T(batch)* batch,
+		const chadfs_sv_t* spath,
+		const void* data,
+		CHADFS_UINT offset,
+		CHADFS_UINT len
+	);
+
+	chadfs_status_t CHADFS_N(commit_batch)(
+		void* dev,
+		const CHADFS_T(loc)* mblkloc,
+		CHADFS_T(batch)* batch
+	);
+/* ================================================= */
+	chadfs_status_t CHADFS_N(count_fragments)(
+		void* dev,
+		const CHADFS_T(loc)* vblkloc,
+		CHADFS_UINT ifirstidblk,
+		CHADFS_UINT* numfragments
+	);
+
+	chadfs_status_t CHADFS_N(init_defrag)(
+		void* dev,
+		const CHADFS_T(loc)* mblkloc,
+		const chadfs_sv_t* sname,
+		uint32_t budget,
+		CHADFS_T(defrag)* defrag
+	);
+
+	chadfs_status_t CHADFS_N(defrag_step)(
+		void* dev,
+		CHADFS_T(defrag)* defrag
+	);
+/* ================================================= */
@@ -0,0 +1,73 @@
+#ifndef CHADFS_BATCH_H
+#define CHADFS_BATCH_H
+
+#include "chadfs-vblk.h"
+#include "chadfs-dirent.h"
+#include "chadfs-journal.h"
+
+/* Queued operation types */
+#define CHADFS_BATCH_CREATE								1U	/* create_file/create_dir */
+#define CHADFS_BATCH_REMOVE								2U	/* remove_file */
+#define CHADFS_BATCH_WRITE								3U	/* write_file */
+/* Dir entries gathered before they are appended to the parent */
+#define CHADFS_BATCH_DIRENTS							64U
+
+/* CHADFS(32) queued operation (path and data are the caller's until the commit) */
+typedef struct _chadfs32_bop_t {
+	uint32_t			type;
+	uint32_t			attributes;
+	chadfs_sv_t			path;
+	const void*			data;
+	uint32_t			offset;
+	uint32_t			len;
+} chadfs32_bop_t;
+
+/* CHADFS(32) metadata batch (see chadfs32_init_batch) */
+typedef struct _chadfs32_batch_t {
+	chadfs32_bop_t*		ops;							/* queued operations */
+	uint32_t			capacity;						/* max num of queued operations */
+	uint32_t			count;
+	void*				buffer;							/* write-back overlay of the commit (OPTIONAL) */
+	size_t				size;
+	chadfs_journal_t	overlay;						/* used when no journal is set */
+
+	uint32_t			vblkaddr;						/* volume being filled (0 - none) */
+	chadfs32_vblk_t		vblk;							/* its block, written back when left */
+	uint32_t			ifree;							/* where the next free fblk search starts */
+	uint32_t			idfree;							/* where the next free dblk search ends (below it) */
+	chadfs_sv_t			pardir;							/* parent dir of the gathered entries */
+	uint32_t			ipardir;						/* its fblk index */
+	uint32_t			numdirents;
+	chadfs32_dirent_t	dirents[CHADFS_BATCH_DIRENTS];
+} chadfs32_batch_t;
+
+/* CHADFS(64) queued operation (see chadfs32_bop_t) */
+typedef struct _chadfs64_bop_t {
+	uint32_t			type;
+	uint32_t			attributes;
+	chadfs_sv_t			path;
+	const void*			data;
+	uint64_t			offset;
+	uint64_t			len;
+} chadfs64_bop_t;
+
+/* CHADFS(64) metadata batch (see chadfs32_batch_t) */
+typedef struct _chadfs64_batch_t {
+	chadfs64_bop_t*		ops;
+	uint32_t			capacity;
+	uint32_t			count;
+	void*				buffer;
+	size_t				size;
+	chadfs_journal_t	overlay;
+
+	uint64_t			vblkaddr;
+	chadfs64_vblk_t		vblk;
+	uint64_t			ifree;
+	uint64_t			idfree;
+	chadfs_sv_t			pardir;
+	uint64_t			ipardir;
+	uint32_t			numdirents;
+	chadfs64_dirent_t	dirents[CHADFS_BATCH_DIRENTS];
+} chadfs64_batch_t;
+
+#endif
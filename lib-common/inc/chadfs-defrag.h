@@ -0,0 +1,55 @@
+#ifndef CHADFS_DEFRAG_H
+#define CHADFS_DEFRAG_H
+
+#include "chadfs-typedefs.h"
+
+/* Directory levels a defrag pass descends (deeper ones are skipped) */
+#define CHADFS_DEFRAG_DEPTH								32U
+
+/* CHADFS(32) defrag position in one directory */
+typedef struct _chadfs32_dpos_t {
+	uint32_t			index;							/* dir fblk index */
+	uint32_t			id;								/* its id, checked before every use */
+	uint32_t			next;							/* 0 - the dir's own data, then its entries from 1 */
+} chadfs32_dpos_t;
+
+/* CHADFS(32) defragmenter (see chadfs32_init_defrag), plain data that can be saved between steps */
+typedef struct _chadfs32_defrag_t {
+	uint32_t			vblkaddr;						/* volume block address */
+	uint8_t				sectorshift;					/* image sector shift */
+	uint32_t			budget;							/* sectors per step (0 - no limit) */
+	uint32_t			depth;							/* dirs on the stack (0 - pass done) */
+	chadfs32_dpos_t		stack[CHADFS_DEFRAG_DEPTH];
+
+	uint64_t			numfiles;						/* files and dirs looked at */
+	uint64_t			nummoved;						/* data chains relocated */
+	uint64_t			numskipped;						/* fragmented but no free run long enough or shared, dirs too deep */
+	uint64_t			fragsbefore;					/* runs of adjacent cells in the looked at chains */
+	uint64_t			fragsafter;
+	uint64_t			numsectors;						/* data sectors moved */
+} chadfs32_defrag_t;
+
+/* CHADFS(64) defrag position (see chadfs32_dpos_t) */
+typedef struct _chadfs64_dpos_t {
+	uint64_t			index;
+	uint64_t			id;
+	uint64_t			next;
+} chadfs64_dpos_t;
+
+/* CHADFS(64) defragmenter (see chadfs32_defrag_t) */
+typedef struct _chadfs64_defrag_t {
+	uint64_t			vblkaddr;
+	uint8_t				sectorshift;
+	uint32_t			budget;
+	uint32_t			depth;
+	chadfs64_dpos_t		stack[CHADFS_DEFRAG_DEPTH];
+
+	uint64_t			numfiles;
+	uint64_t			nummoved;
+	uint64_t			numskipped;
+	uint64_t			fragsbefore;
+	uint64_t			fragsafter;
+	uint64_t			numsectors;
+} chadfs64_defrag_t;
+
+#endif
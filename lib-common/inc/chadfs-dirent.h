@@ -4,12 +4,20 @@
 #include "chadfs-typedefs.h"
 
 #pragma pack(push, 1)
-#define CHADFS_NUMOF_DIR_DBLK_ENTRIES					(CHADFS_SECTOR_SIZE / sizeof(chadfs32_dirent_t))
+/* Num of dir entries in a `__ssize`-byte sector */
+#define CHADFS32_DIR_DBLK_ENTRIES(__ssize)				((__ssize) / sizeof(chadfs32_dirent_t))
 /* CHADFS(32) dir entry */
 typedef struct _chadfs32_dirent_t {
 	uint32_t		id;
 	uint32_t		index;
 } chadfs32_dirent_t;
+
+#define CHADFS64_DIR_DBLK_ENTRIES(__ssize)				((__ssize) / sizeof(chadfs64_dirent_t))
+/* CHADFS(64) dir entry */
+typedef struct _chadfs64_dirent_t {
+	uint64_t		id;
+	uint64_t		index;
+} chadfs64_dirent_t;
 #pragma pack(pop)
 
 #endif
\ No newline at end of file
@@ -0,0 +1,14 @@
+#ifndef CHADFS_DISCARD_H
+#define CHADFS_DISCARD_H
+
+#include "chadfs-typedefs.h"
+
+/*
+	CHADFS discarder (sink for sector ranges that hold no live data any
+	more), discarded sectors must read as zeros afterwards
+*/
+typedef struct _chadfs_discarder_t {
+	void			(*discard)(void* dev, uint64_t address, uint64_t count);
+} chadfs_discarder_t;
+
+#endif
@@ -10,15 +10,54 @@
 #define CHADFS_FILE_ATTRIBUTE_READABLE					0x04U
 #define CHADFS_FILE_ATTRIBUTE_WRITEABLE					0x08U
 #define CHADFS_FILE_ATTRIBUTE_HIDDEN					0x10U
-/* CHADFS(32) file block */
-typedef struct _chadfs32_fblk_t {
-	uint8_t			name[CHADFS_MAX_FILE_NAME + 1];
-	uint32_t		size;
-	uint32_t		firstdblk;
-	uint32_t		lastdblk;
-	uint32_t		attributes;
-	uint8_t			reserved[CHADFS_SECTOR_SIZE - 272];
-} chadfs32_fblk_t;
+#define CHADFS_FILE_ATTRIBUTE_COMPRESSED				0x20U
+/* Bytes of file data per independently compressed chunk (see CHADFS32_CHUNK_FLAG) */
+#define CHADFS_CHUNK_SIZE								0x4000U
+/* CHADFS(32) file block filling one `__ssize` byte sector (chadfs32_fblk_t - the largest one) */
+#define CHADFS32_FBLK_BODY(__ssize)						\
+{																								\
+	uint8_t			name[CHADFS_MAX_FILE_NAME + 1];												\
+	uint32_t		size;																		\
+	uint32_t		firstdblk;																	\
+	uint32_t		lastdblk;																	\
+	uint32_t		attributes;																	\
+	uint32_t		prealloc;		/* first cell of the preallocated run (see chadfs32_prealloc_file) */	\
+	uint32_t		numprealloc;	/* its cells, reserved but not written yet */				\
+	uint32_t		numholes;		/* hole links in the chain (see CHADFS32_HOLE_FLAG) */		\
+	uint32_t		holeclusters;	/* clusters they cover */									\
+	uint32_t		numcells;		/* cells of a compressed file's chain */					\
+	uint32_t		lastchunk;		/* first cell of its last chunk */							\
+	uint32_t		chunktail;		/* last cell before it (0 - one chunk) */					\
+	uint32_t		nextshare;		/* next file block in the ring sharing its chain (0 - none, see chadfs32_share_file) */	\
+	uint8_t			reserved[(__ssize) - 304];													\
+}
+typedef struct _chadfs32_fblk_t CHADFS32_FBLK_BODY(CHADFS_MAX_SECTOR_SIZE) chadfs32_fblk_t;
+
+/* CHADFS(64) file block */
+#define CHADFS64_FBLK_BODY(__ssize)						\
+{																								\
+	uint8_t			name[CHADFS_MAX_FILE_NAME + 1];												\
+	uint64_t		size;																		\
+	uint64_t		firstdblk;																	\
+	uint64_t		lastdblk;																	\
+	uint32_t		attributes;																	\
+	uint64_t		prealloc;																	\
+	uint64_t		numprealloc;																\
+	uint64_t		numholes;																	\
+	uint64_t		holeclusters;																\
+	uint64_t		numcells;																	\
+	uint64_t		lastchunk;																	\
+	uint64_t		chunktail;																	\
+	uint64_t		nextshare;																	\
+	uint8_t			reserved[(__ssize) - 348];													\
+}
+typedef struct _chadfs64_fblk_t CHADFS64_FBLK_BODY(CHADFS_MAX_SECTOR_SIZE) chadfs64_fblk_t;
+
+#if CHADFS_MAX_SECTOR_SIZE > 512
+/* The same for 512-byte sector code (see CHADFS_B) */
+typedef struct _chadfs32_s512_fblk_t CHADFS32_FBLK_BODY(512U) chadfs32_s512_fblk_t;
+typedef struct _chadfs64_s512_fblk_t CHADFS64_FBLK_BODY(512U) chadfs64_s512_fblk_t;
+#endif
 #pragma pack(pop)
 
 #endif
\ No newline at end of file
@@ -14,12 +14,65 @@ typedef struct _chadfs32_idata_t {
 	uint32_t		nextdata;
 } chadfs32_idata_t;
 
-#define CHADFS_NUMOF_IBLK_ENTRIES						(CHADFS_SECTOR_SIZE >> 3)
-/* CHADFS(32) id block */
-typedef union _chadfs32_iblk_t {
-	chadfs32_ifile_t	f[CHADFS_NUMOF_IBLK_ENTRIES];
-	chadfs32_idata_t	d[CHADFS_NUMOF_IBLK_ENTRIES];
-} chadfs32_iblk_t;
+/*
+	A chain link whose numbytes has the hole flag set holds no data: its
+	cell is unused and the low bits are whole clusters that read as zeros
+*/
+#define CHADFS32_HOLE_FLAG								0x80000000U
+/*
+	The chain of a compressed file is a run of chunks, each starting with
+	a link flagged as its first, packed when the chunk is LZ4 compressed
+	(stored raw otherwise). Link numbytes low bits are the stored bytes
+*/
+#define CHADFS32_CHUNK_FLAG								0x40000000U
+#define CHADFS32_PACKED_FLAG							0x20000000U
+#define CHADFS32_IBLK_ENTRIES(__ssize)					((__ssize) >> 3)
+#define CHADFS32_NUMOF_IBLK_ENTRIES						CHADFS32_IBLK_ENTRIES(CHADFS_MAX_SECTOR_SIZE)
+/* CHADFS(32) id block filling one `__ssize` byte sector (chadfs32_iblk_t - the largest one, the image sector size sets the used part) */
+#define CHADFS32_IBLK_BODY(__ssize)						\
+{																								\
+	chadfs32_ifile_t	f[CHADFS32_IBLK_ENTRIES(__ssize)];										\
+	chadfs32_idata_t	d[CHADFS32_IBLK_ENTRIES(__ssize)];										\
+}
+typedef union _chadfs32_iblk_t CHADFS32_IBLK_BODY(CHADFS_MAX_SECTOR_SIZE) chadfs32_iblk_t;
+
+typedef struct _chadfs64_ifile_t {
+	uint64_t		id;
+	uint64_t		active;
+} chadfs64_ifile_t;
+
+typedef struct _chadfs64_idata_t {
+	uint64_t		numbytes;
+	uint64_t		nextdata;
+} chadfs64_idata_t;
+
+#define CHADFS64_HOLE_FLAG								0x8000000000000000U
+#define CHADFS64_CHUNK_FLAG								0x4000000000000000U
+#define CHADFS64_PACKED_FLAG							0x2000000000000000U
+#define CHADFS64_IBLK_ENTRIES(__ssize)					((__ssize) >> 4)
+#define CHADFS64_NUMOF_IBLK_ENTRIES						CHADFS64_IBLK_ENTRIES(CHADFS_MAX_SECTOR_SIZE)
+/* CHADFS(64) id block */
+#define CHADFS64_IBLK_BODY(__ssize)						\
+{																								\
+	chadfs64_ifile_t	f[CHADFS64_IBLK_ENTRIES(__ssize)];										\
+	chadfs64_idata_t	d[CHADFS64_IBLK_ENTRIES(__ssize)];										\
+}
+typedef union _chadfs64_iblk_t CHADFS64_IBLK_BODY(CHADFS_MAX_SECTOR_SIZE) chadfs64_iblk_t;
+
+#if CHADFS_MAX_SECTOR_SIZE > 512
+/* The same for 512-byte sector code (see CHADFS_B) */
+typedef union _chadfs32_s512_iblk_t CHADFS32_IBLK_BODY(512U) chadfs32_s512_iblk_t;
+typedef union _chadfs64_s512_iblk_t CHADFS64_IBLK_BODY(512U) chadfs64_s512_iblk_t;
+#endif
 #pragma pack(pop)
 
+/*
+	Width code (see chadfs-tmpl.h): a hole link, the clusters a link
+	spans, a compressed chunk's first link, the bytes stored in a data link
+*/
+#define CHADFS_IS_HOLE(__entry)							(((__entry)->numbytes & CHADFS_C(HOLE_FLAG)) != 0)
+#define CHADFS_LINK_CLUSTERS(__entry)					(CHADFS_IS_HOLE(__entry) ? (__entry)->numbytes & ~CHADFS_C(HOLE_FLAG) : 1)
+#define CHADFS_IS_CHUNK(__entry)						(((__entry)->numbytes & (CHADFS_C(HOLE_FLAG) | CHADFS_C(CHUNK_FLAG))) == CHADFS_C(CHUNK_FLAG))
+#define CHADFS_CELL_BYTES(__entry)						((__entry)->numbytes & ~(CHADFS_C(CHUNK_FLAG) | CHADFS_C(PACKED_FLAG)))
+
 #endif
\ No newline at end of file
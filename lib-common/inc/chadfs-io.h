@@ -0,0 +1,110 @@
+#ifndef CHADFS_IO_H
+#define CHADFS_IO_H
+
+#include "chadfs-stats.h"
+#include "chadfs-journal.h"
+#include "chadfs-discard.h"
+
+/*
+	Sector access used by the library itself, every call to
+	chadfs32_read_sector/chadfs32_write_sector goes through these
+*/
+void chadfs32_io_read_sector(
+	void* dev,
+	uint32_t address,
+	void* sectordata
+);
+
+void chadfs32_io_write_sector(
+	void* dev,
+	uint32_t address,
+	const void* sectordata
+);
+
+void chadfs64_io_read_sector(
+	void* dev,
+	uint64_t address,
+	void* sectordata
+);
+
+void chadfs64_io_write_sector(
+	void* dev,
+	uint64_t address,
+	const void* sectordata
+);
+
+/*
+	Write a data sector (payload of write_data/append_file/stream writer),
+	file data bypasses the journal (see CHADFS_DATA_SCOPE)
+*/
+void chadfs32_io_write_data(
+	void* dev,
+	uint32_t address,
+	const void* sectordata
+);
+
+void chadfs64_io_write_data(
+	void* dev,
+	uint64_t address,
+	const void* sectordata
+);
+
+/*
+	Split `buffer` into the storage of `journal` for up to `maxcount`
+	sectors, returns the capacity (0 - too small)
+*/
+uint32_t chadfs_journal_layout(
+	chadfs_journal_t* journal,
+	void* buffer,
+	size_t size,
+	uint32_t sectorsize,
+	size_t maxcount
+);
+
+/*
+	Drop all logged sectors and queued discards
+*/
+void chadfs_journal_reset(
+	chadfs_journal_t* journal
+);
+
+/*
+	Pass the queued discards to the discarder once the logged sectors are
+	home (sectors logged again, reused cells, are left out)
+*/
+void chadfs_journal_discard(
+	chadfs_journal_t* journal
+);
+
+/*
+	Cells were freed, they may be reused before the commit
+*/
+void chadfs_io_note_free(void);
+
+/*
+	Pass `count` sectors from `address` to the discarder, false - they
+	keep their old bytes (no discarder, or until the commit of the journal
+	that logs the metadata still pointing at them)
+*/
+bool chadfs_io_discard(
+	void* dev,
+	uint64_t address,
+	uint64_t count
+);
+
+bool chadfs_io_enter_data(
+	bool filedata
+);
+
+void chadfs_io_leave_data(
+	bool* prev
+);
+
+/*
+	Payload written in the rest of the function is file data (`__filedata`)
+	or directory entries (metadata)
+*/
+#define CHADFS_DATA_SCOPE(__filedata)					\
+	bool __datascope __attribute__((cleanup(chadfs_io_leave_data))) = chadfs_io_enter_data(__filedata)
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef CHADFS_JOURNAL_H
+#define CHADFS_JOURNAL_H
+
+#include "chadfs-typedefs.h"
+
+#pragma pack(push, 1)
+#define CHADFS_JOURNAL_SIGNATURE						"CHADJRN1"
+/* Journal area: record header + logged sectors */
+#define CHADFS_MIN_JOURNAL_SECTORS						2U
+#define CHADFS32_JOURNAL_ENTRIES(__ssize)				(((__ssize) - 24U) >> 2)
+#define CHADFS64_JOURNAL_ENTRIES(__ssize)				(((__ssize) - 24U) >> 3)
+/* CHADFS(32) journal record header filling one `__ssize` byte sector, the first of the journal area (chadfs32_jhdr_t - the largest one) */
+#define CHADFS32_JHDR_BODY(__ssize)						\
+{																								\
+	uint8_t			signature[8];						/* CHADFS_JOURNAL_SIGNATURE */			\
+	uint64_t		seq;																		\
+	uint32_t		numsectors;							/* 0 - checkpointed, nothing to replay */	\
+	uint32_t		csum;								/* Murmur3 of addresses and logged sectors */	\
+	uint32_t		addresses[CHADFS32_JOURNAL_ENTRIES(__ssize)];								\
+}
+typedef struct _chadfs32_jhdr_t CHADFS32_JHDR_BODY(CHADFS_MAX_SECTOR_SIZE) chadfs32_jhdr_t;
+
+/* CHADFS(64) journal record header */
+#define CHADFS64_JHDR_BODY(__ssize)						\
+{																								\
+	uint8_t			signature[8];																\
+	uint64_t		seq;																		\
+	uint32_t		numsectors;																	\
+	uint32_t		csum;																		\
+	uint64_t		addresses[CHADFS64_JOURNAL_ENTRIES(__ssize)];								\
+}
+typedef struct _chadfs64_jhdr_t CHADFS64_JHDR_BODY(CHADFS_MAX_SECTOR_SIZE) chadfs64_jhdr_t;
+
+#if CHADFS_MAX_SECTOR_SIZE > 512
+/* The same for 512-byte sector code (see CHADFS_B) */
+typedef struct _chadfs32_s512_jhdr_t CHADFS32_JHDR_BODY(512U) chadfs32_s512_jhdr_t;
+typedef struct _chadfs64_s512_jhdr_t CHADFS64_JHDR_BODY(512U) chadfs64_s512_jhdr_t;
+#endif
+#pragma pack(pop)
+
+/* Max num of freed sector ranges a journal holds until its commit */
+#define CHADFS_JOURNAL_DISCARDS							32U
+
+/* Freed sector range (see chadfs_journal_t) */
+typedef struct _chadfs_jrange_t {
+	uint64_t		address;
+	uint64_t		count;
+} chadfs_jrange_t;
+
+/*
+	Metadata journal (caller owned, see chadfs32_begin_journal). While
+	it is set for the thread, metadata writes to `dev` are logged in
+	memory (and served back to reads), file data goes in place. A commit
+	writes the logged sectors as one sequential record to the journal
+	area, then to their home locations. Sectors freed in between are
+	passed to the discarder after that (adjacent ranges merged, ranges
+	beyond CHADFS_JOURNAL_DISCARDS and those of a journal reset without
+	a commit are not discarded)
+*/
+typedef struct _chadfs_journal_t {
+	void*			dev;
+	void			(*flush)(void* dev);				/* write barrier (OPTIONAL) */
+	uint64_t		jaddr;								/* journal area address (0 - none, write-back only) */
+	uint64_t		seq;								/* last written record */
+	uint64_t*		addresses;							/* home addresses of logged sectors */
+	uint32_t*		slots;								/* address hash (index + 1, 0 - empty) */
+	uint8_t*		sectors;							/* logged sectors */
+	uint32_t		numslots;							/* power of two, at least twice the capacity */
+	uint32_t		capacity;							/* max num of logged sectors */
+	uint32_t		count;
+	uint32_t		sectorsize;
+	uint8_t			version;							/* CHADFS_VERSION32/CHADFS_VERSION64 */
+	bool			freed;								/* cells were freed, log file data too until commit */
+	bool			clearing;							/* checkpointed record not invalidated on disk yet */
+	uint64_t		commits;							/* num of written records */
+	uint32_t		numdiscards;
+	chadfs_jrange_t	discards[CHADFS_JOURNAL_DISCARDS];	/* freed sector ranges, discarded after the commit */
+} chadfs_journal_t;
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef CHADFS_LZ_H
+#define CHADFS_LZ_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Largest input of one chadfs_lz_compress call (match offsets are 16 bit) */
+#define CHADFS_LZ_MAX_INPUT								0x10000U
+/* chadfs_lz_decompress result for malformed input */
+#define CHADFS_LZ_ERROR									((size_t)-1)
+
+/*
+	Compress `len` bytes into LZ4 block format, returns the compressed
+	size, 0 - it would not fit in `cap` bytes (store the data raw)
+*/
+size_t chadfs_lz_compress(
+	const void* src,
+	size_t len,
+	void* dst,
+	size_t cap
+);
+
+/*
+	Decompress an LZ4 block, returns the decompressed size or
+	CHADFS_LZ_ERROR (malformed block, more than `cap` bytes)
+*/
+size_t chadfs_lz_decompress(
+	const void* src,
+	size_t len,
+	void* dst,
+	size_t cap
+);
+
+#endif
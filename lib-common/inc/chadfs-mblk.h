@@ -6,17 +6,42 @@
 #pragma pack(push, 1)
 #define CHADFS_SIGNATURE								"CHADFS  "
 #define CHADFS_VERSION32								32U
-/* CHADFS(32) main block */
-typedef struct _chadfs32_mblk_t {
-	uint8_t			signature[8];						/* CHADFS_SIGNATURE */
-	uint8_t			version;
-	uint8_t			csum;
+#define CHADFS_VERSION64								64U
+/* CHADFS(32) main block filling one `__ssize` byte sector (chadfs32_mblk_t - the largest one) */
+#define CHADFS32_MBLK_BODY(__ssize)						\
+{																								\
+	uint8_t			signature[8];						/* CHADFS_SIGNATURE */					\
+	uint8_t			version;																	\
+	uint8_t			csum;																		\
+																								\
+	uint32_t		numvolumes;																	\
+	uint32_t		firstvolume;																\
+	uint8_t			sectorshift;						/* sector = CHADFS_MIN_SECTOR_SIZE << sectorshift */	\
+																								\
+	uint8_t			reserved[(__ssize) - 19];													\
+}
+typedef struct _chadfs32_mblk_t CHADFS32_MBLK_BODY(CHADFS_MAX_SECTOR_SIZE) chadfs32_mblk_t;
 
-	uint32_t		numvolumes;
-	uint32_t		firstvolume;
+/* CHADFS(64) main block */
+#define CHADFS64_MBLK_BODY(__ssize)						\
+{																								\
+	uint8_t			signature[8];						/* CHADFS_SIGNATURE */					\
+	uint8_t			version;																	\
+	uint8_t			csum;																		\
+																								\
+	uint32_t		numvolumes;																	\
+	uint64_t		firstvolume;																\
+	uint8_t			sectorshift;																\
+																								\
+	uint8_t			reserved[(__ssize) - 23];													\
+}
+typedef struct _chadfs64_mblk_t CHADFS64_MBLK_BODY(CHADFS_MAX_SECTOR_SIZE) chadfs64_mblk_t;
 
-	uint8_t			reserved[CHADFS_SECTOR_SIZE - 18];
-} chadfs32_mblk_t;
+#if CHADFS_MAX_SECTOR_SIZE > 512
+/* The same for 512-byte sector code (see CHADFS_B) */
+typedef struct _chadfs32_s512_mblk_t CHADFS32_MBLK_BODY(512U) chadfs32_s512_mblk_t;
+typedef struct _chadfs64_s512_mblk_t CHADFS64_MBLK_BODY(512U) chadfs64_s512_mblk_t;
+#endif
 #pragma pack(pop)
 
 #endif
\ No newline at end of file
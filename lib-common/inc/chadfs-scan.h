@@ -0,0 +1,72 @@
+#ifndef CHADFS_SCAN_H
+#define CHADFS_SCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+	ID table entry scans of one id block. Entries are pairs of words
+	(CHADFS(32) - uint32_t, CHADFS(64) - uint64_t), ifile id/active or
+	idata numbytes/nextdata. Hosted x86 builds pick SSE2/AVX2 kernels at
+	the first call (CHADFS(64) - AVX2 only), other builds (e.g.
+	freestanding) scan entry by entry
+*/
+typedef enum _chadfs_scan_isa_t {
+	CHADFS_SCAN_AUTO,									/* the best one the CPU has */
+	CHADFS_SCAN_SCALAR,
+	CHADFS_SCAN_SSE2,
+	CHADFS_SCAN_AVX2
+} chadfs_scan_isa_t;
+
+/* rscan result when no entry matches */
+#define CHADFS_SCAN_NONE								UINT32_MAX
+
+/*
+	Use kernels of `isa` (at most the best one the CPU has), returns the
+	level in use
+*/
+chadfs_scan_isa_t chadfs_set_scan_isa(
+	chadfs_scan_isa_t isa
+);
+
+chadfs_scan_isa_t chadfs_get_scan_isa(void);
+
+const char* chadfs_scan_isa_str(
+	chadfs_scan_isa_t isa
+);
+
+/*
+	Find the first entry in [ifrom, count) equal to `first`/`second`,
+	returns its index or `count`
+*/
+uint32_t chadfs32_scan_pairs(
+	const void* entries,
+	uint32_t ifrom,
+	uint32_t count,
+	uint32_t first,
+	uint32_t second
+);
+
+uint32_t chadfs64_scan_pairs(
+	const void* entries,
+	uint32_t ifrom,
+	uint32_t count,
+	uint64_t first,
+	uint64_t second
+);
+
+/*
+	Find the last entry in [0, count) with the first word 0, returns its
+	index or CHADFS_SCAN_NONE
+*/
+uint32_t chadfs32_rscan_zero(
+	const void* entries,
+	uint32_t count
+);
+
+uint32_t chadfs64_rscan_zero(
+	const void* entries,
+	uint32_t count
+);
+
+#endif
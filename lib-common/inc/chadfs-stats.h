@@ -0,0 +1,94 @@
+#ifndef CHADFS_STATS_H
+#define CHADFS_STATS_H
+
+#include "chadfs-typedefs.h"
+
+/* Public API operations (I/O is accounted to the outermost one) */
+typedef enum _chadfs_op_t {
+	CHADFS_OP_NONE,										/* access outside of any API call */
+	CHADFS_OP_FIND_FREE_FBLK,
+	CHADFS_OP_FIND_FREE_DBLK,
+	CHADFS_OP_FIND_NEXT_FREE_DBLK,
+	CHADFS_OP_READ_MBLK,
+	CHADFS_OP_READ_VBLK,
+	CHADFS_OP_READ_FBLK,
+	CHADFS_OP_WRITE_DATA,
+	CHADFS_OP_READ_DATA,
+	CHADFS_OP_CUT_DATA,
+	CHADFS_OP_CREATE_FILE,
+	CHADFS_OP_CREATE_DIR,
+	CHADFS_OP_READ_FILE,
+	CHADFS_OP_APPEND_FILE,
+	CHADFS_OP_TRUNC_FILE,
+	CHADFS_OP_REMOVE_FILE,
+	CHADFS_OP_WRITE_FILE,
+	CHADFS_OP_ADD_VOLUME,
+	CHADFS_OP_CREATE_ITER,
+	CHADFS_OP_MOVE_ITER,
+	CHADFS_OP_OPEN_READER,
+	CHADFS_OP_READ_CHUNK,
+	CHADFS_OP_OPEN_WRITER,
+	CHADFS_OP_WRITE_CHUNK,
+	CHADFS_OP_CLOSE_WRITER,
+	CHADFS_OP_BEGIN_JOURNAL,
+	CHADFS_OP_COMMIT_JOURNAL,
+	CHADFS_OP_REPLAY_JOURNALS,
+	CHADFS_OP_COMMIT_BATCH,
+	CHADFS_OP_FLUSH_WRITER,
+	CHADFS_OP_PREALLOC_FILE,
+	CHADFS_OP_COUNT_FRAGMENTS,
+	CHADFS_OP_DEFRAG_STEP,
+	CHADFS_OP_RECLAIM,
+	CHADFS_OP_PUNCH_HOLE,
+	CHADFS_OP_SHARE_FILE,
+	CHADFS_OP_COPY_FILE,
+	CHADFS_OP_RENAME_FILE,
+	CHADFS_OP_REMOVE_TREE,
+	CHADFS_NUMOF_OPS
+} chadfs_op_t;
+
+/* CHADFS per-operation counters */
+typedef struct _chadfs_opstats_t {
+	uint64_t	calls;									/* num of top-level calls */
+	uint64_t	sreads;									/* sector reads */
+	uint64_t	swrites;								/* sector writes */
+	uint64_t	chits;									/* cache hits (reported by device) */
+	uint64_t	cmisses;								/* cache misses (reported by device) */
+	uint64_t	bytes;									/* payload bytes read or written */
+	uint64_t	time;									/* spent time (in clock ticks) */
+} chadfs_opstats_t;
+
+/* CHADFS stats */
+typedef struct _chadfs_stats_t {
+	chadfs_opstats_t	ops[CHADFS_NUMOF_OPS];
+	uint64_t			(*clock)(void);					/* time source (OPTIONAL) */
+} chadfs_stats_t;
+
+/* API call scope (see CHADFS_OP_SCOPE) */
+typedef struct _chadfs_opscope_t {
+	chadfs_op_t	op;										/* CHADFS_OP_NONE if nested */
+	uint64_t	start;									/* clock value at entry */
+} chadfs_opscope_t;
+
+chadfs_opscope_t chadfs_op_enter(
+	chadfs_op_t op
+);
+
+void chadfs_op_leave(
+	chadfs_opscope_t* scope
+);
+
+void chadfs_op_add_bytes(
+	const chadfs_opscope_t* scope,
+	uint64_t bytes
+);
+
+/*
+	Account the rest of the function to `__op`. Only the outermost
+	scope counts, so nested API calls are folded into their caller.
+*/
+#define CHADFS_OP_SCOPE(__op)							\
+	chadfs_opscope_t __opscope __attribute__((cleanup(chadfs_op_leave))) = chadfs_op_enter(__op)
+#define CHADFS_OP_BYTES(__n)							chadfs_op_add_bytes(&__opscope, (__n))
+
+#endif
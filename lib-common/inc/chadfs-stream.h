@@ -0,0 +1,121 @@
+#ifndef CHADFS_STREAM_H
+#define CHADFS_STREAM_H
+
+#include "chadfs-iblk.h"
+#include "chadfs-fblk.h"
+
+/* CHADFS(32) data reader (yields one data sector per chunk) */
+typedef struct _chadfs32_reader_t {
+	uint32_t			itbladdr;						/* id table address */
+	uint32_t			dtbladdr;						/* data table address */
+	uint8_t				clustershift;					/* volume cluster shift */
+	uint8_t				sectorshift;					/* image sector shift */
+	uint32_t			icurrent;						/* current chadfs32_idata_t index */
+	uint32_t			isector;						/* current sector in the cluster (or hole) */
+	uint32_t			skip;							/* bytes to skip in the current sector */
+	uint32_t			left;							/* bytes left to read */
+
+	uint32_t			iiblk;							/* index of the cached id block */
+	chadfs32_iblk_t		iblk;							/* cached id block */
+
+	bool				packed;							/* compressed chain, icurrent - the next chunk */
+	uint32_t			chunkpos;						/* next byte of the unpacked chunk */
+	uint32_t			chunklen;						/* its bytes */
+	uint8_t				chunk[CHADFS_CHUNK_SIZE];		/* unpacked chunk */
+} chadfs32_reader_t;
+
+/* CHADFS(32) data writer (appends to the end of file, commits at close, see chadfs32_open_delayed_writer) */
+typedef struct _chadfs32_writer_t {
+	uint32_t			vblkaddr;						/* volume block address */
+	uint32_t			fblkaddr;						/* file block address */
+	uint32_t			itbladdr;						/* id table address */
+	uint32_t			dtbladdr;						/* data table address */
+	uint8_t				clustershift;					/* volume cluster shift */
+	uint8_t				sectorshift;					/* image sector shift */
+	uint32_t			clustersize;					/* cluster size in bytes */
+	uint32_t			numientries;					/* num of id table entries */
+	uint32_t			freeblks;						/* free blocks at open */
+	uint32_t			addedblks;						/* data blocks allocated so far */
+	uint32_t			ifree;							/* where the next free index search starts */
+	uint32_t			fill;							/* bytes in the last cluster (clustersize - full) */
+	uint32_t			runnext;						/* next cell of the reserved free run */
+	uint32_t			runleft;						/* cells left in the reserved free run */
+	uint8_t*			pending;						/* delayed allocation buffer (NULL - allocate as written) */
+	size_t				pendingsize;
+	size_t				numpending;						/* buffered bytes, not in fblk.size yet */
+	chadfs32_fblk_t		fblk;							/* file block (size, chain head and tail) */
+
+	uint32_t			iiblk;							/* index of the cached id block */
+	bool				iblkdirty;
+	chadfs32_iblk_t		iblk;							/* cached id block */
+	uint8_t				tail[CHADFS_MAX_SECTOR_SIZE];		/* partially filled last sector */
+
+	uint32_t			chunkfill;						/* bytes gathered for a compressed file, not in fblk.size yet */
+	uint8_t				chunk[CHADFS_CHUNK_SIZE];		/* appended a chunk at a time, behind the bytes of a partial last one */
+} chadfs32_writer_t;
+
+/* CHADFS(32) scratch of a streamed file copy (see chadfs32_copy_file) */
+typedef struct _chadfs32_copier_t {
+	chadfs32_reader_t	reader;
+	chadfs32_writer_t	writer;
+	uint8_t				sector[CHADFS_MAX_SECTOR_SIZE];	/* data on its way from the reader to the writer */
+} chadfs32_copier_t;
+
+/* CHADFS(64) data reader (see chadfs32_reader_t) */
+typedef struct _chadfs64_reader_t {
+	uint64_t			itbladdr;
+	uint64_t			dtbladdr;
+	uint8_t				clustershift;
+	uint8_t				sectorshift;
+	uint64_t			icurrent;
+	uint64_t			isector;
+	uint64_t			skip;
+	uint64_t			left;
+
+	uint64_t			iiblk;
+	chadfs64_iblk_t		iblk;
+
+	bool				packed;
+	uint64_t			chunkpos;
+	uint64_t			chunklen;
+	uint8_t				chunk[CHADFS_CHUNK_SIZE];
+} chadfs64_reader_t;
+
+/* CHADFS(64) data writer (see chadfs32_writer_t) */
+typedef struct _chadfs64_writer_t {
+	uint64_t			vblkaddr;
+	uint64_t			fblkaddr;
+	uint64_t			itbladdr;
+	uint64_t			dtbladdr;
+	uint8_t				clustershift;
+	uint8_t				sectorshift;
+	uint32_t			clustersize;
+	uint64_t			numientries;
+	uint64_t			freeblks;
+	uint64_t			addedblks;
+	uint64_t			ifree;
+	uint64_t			fill;
+	uint64_t			runnext;
+	uint64_t			runleft;
+	uint8_t*			pending;
+	size_t				pendingsize;
+	size_t				numpending;
+	chadfs64_fblk_t		fblk;
+
+	uint64_t			iiblk;
+	bool				iblkdirty;
+	chadfs64_iblk_t		iblk;
+	uint8_t				tail[CHADFS_MAX_SECTOR_SIZE];
+
+	uint64_t			chunkfill;
+	uint8_t				chunk[CHADFS_CHUNK_SIZE];
+} chadfs64_writer_t;
+
+/* CHADFS(64) scratch of a streamed file copy (see chadfs32_copier_t) */
+typedef struct _chadfs64_copier_t {
+	chadfs64_reader_t	reader;
+	chadfs64_writer_t	writer;
+	uint8_t				sector[CHADFS_MAX_SECTOR_SIZE];
+} chadfs64_copier_t;
+
+#endif
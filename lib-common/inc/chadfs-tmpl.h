@@ -0,0 +1,68 @@
+#ifndef CHADFS_TMPL_H
+#define CHADFS_TMPL_H
+
+/*
+	Names for code written once and compiled per format width. CHADFS_W
+	(32 or 64) must be defined where they are expanded, e.g. with 64:
+	CHADFS_N(read_fblk) - chadfs64_read_fblk, CHADFS_T(fblk) - chadfs64_fblk_t,
+	CHADFS_C(IBLK_ENTRIES) - CHADFS64_IBLK_ENTRIES, CHADFS_UINT - uint64_t
+*/
+#define CHADFS_CAT(__a, __b, __c)						__a##__b##__c
+#define CHADFS_XCAT(__a, __b, __c)						CHADFS_CAT(__a, __b, __c)
+#define CHADFS_N(__name)								CHADFS_XCAT(chadfs, CHADFS_W, _##__name)
+#define CHADFS_T(__name)								CHADFS_XCAT(chadfs, CHADFS_W, _##__name##_t)
+#define CHADFS_C(__name)								CHADFS_XCAT(CHADFS, CHADFS_W, _##__name)
+#define CHADFS_UINT										CHADFS_XCAT(uint, CHADFS_W, _t)
+#define CHADFS_UINT_MAX									CHADFS_XCAT(UINT, CHADFS_W, _MAX)
+#define CHADFS_VERSION_W								CHADFS_XCAT(CHADFS_VERSION, CHADFS_W, )
+
+/*
+	Width level name, the same inside sector size variants
+	(e.g. CHADFS_P(io_read_sector) - chadfs64_io_read_sector)
+*/
+#define CHADFS_P(__name)								CHADFS_XCAT(chadfs, CHADFS_W, _##__name)
+/* Sector size variant name, e.g. CHADFS_V(4096, read_fblk) - chadfs64_s4096_read_fblk */
+#define CHADFS_V(__s, __name)							CHADFS_XCAT(CHADFS_XCAT(chadfs, CHADFS_W, _s), __s, _##__name)
+/* Sector block type, CHADFS_T outside sector size variants (see below) */
+#define CHADFS_B(__name)								CHADFS_T(__name)
+
+#endif
+
+/*
+	Included again by the per-width translation units after CHADFS_W is
+	defined, and around every sector size variant (CHADFS_S - 512 or 4096,
+	defined - variant code, CHADFS_N names the variant and the geometry
+	is constant; undefined - back to width level names)
+*/
+#ifdef CHADFS_W
+#undef CHADFS_N
+#undef CHADFS_SECTOR_SIZE
+#undef CHADFS_SECTOR_SHIFT
+#undef CHADFS_NUMOF_IBLK_ENTRIES
+#undef CHADFS_NUMOF_DIR_DBLK_ENTRIES
+#undef CHADFS_B
+#ifdef CHADFS_S
+#define CHADFS_N(__name)								CHADFS_V(CHADFS_S, __name)
+#define CHADFS_SECTOR_SIZE								CHADFS_XCAT(CHADFS_S, U, )
+#if CHADFS_S == 4096
+#define CHADFS_SECTOR_SHIFT								3U
+#else
+#define CHADFS_SECTOR_SHIFT								0U
+#endif
+#define CHADFS_NUMOF_IBLK_ENTRIES						CHADFS_C(IBLK_ENTRIES)(CHADFS_SECTOR_SIZE)
+#define CHADFS_NUMOF_DIR_DBLK_ENTRIES					CHADFS_C(DIR_DBLK_ENTRIES)(CHADFS_SECTOR_SIZE)
+/*
+	Sector block (mblk, vblk, fblk, iblk, jhdr) one variant sector long,
+	e.g. CHADFS_B(fblk) - chadfs64_s512_fblk_t. Blocks shared through the
+	API (CHADFS_T) stay CHADFS_MAX_SECTOR_SIZE long and are cast to it
+*/
+#if CHADFS_S < CHADFS_MAX_SECTOR_SIZE
+#define CHADFS_B(__name)								CHADFS_V(CHADFS_S, __name##_t)
+#else
+#define CHADFS_B(__name)								CHADFS_T(__name)
+#endif
+#else
+#define CHADFS_N(__name)								CHADFS_XCAT(chadfs, CHADFS_W, _##__name)
+#define CHADFS_B(__name)								CHADFS_T(__name)
+#endif
+#endif
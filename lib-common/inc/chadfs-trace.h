@@ -0,0 +1,44 @@
+#ifndef CHADFS_TRACE_H
+#define CHADFS_TRACE_H
+
+#include "chadfs-stats.h"
+
+#pragma pack(push, 1)
+#define CHADFS_TRACE_SIGNATURE							"CHADTRC2"
+#define CHADFS_TRACE_SIGNATURE_V1						"CHADTRC1"		/* 32-bit LBAs (chadfs_trace_rec_v1_t) */
+/* CHADFS trace file header */
+typedef struct _chadfs_trace_hdr_t {
+	uint8_t			signature[8];						/* CHADFS_TRACE_SIGNATURE */
+	uint32_t		sectorsize;
+	uint32_t		reserved;
+} chadfs_trace_hdr_t;
+
+#define CHADFS_TRACE_READ								0x00U
+#define CHADFS_TRACE_WRITE								0x01U
+/* CHADFS trace record (one per sector access) */
+typedef struct _chadfs_trace_rec_t {
+	uint8_t			type;								/* CHADFS_TRACE_READ/CHADFS_TRACE_WRITE */
+	uint8_t			op;									/* chadfs_op_t of the caller API */
+	uint8_t			reserved[6];
+	uint64_t		address;							/* LBA */
+	uint64_t		time;								/* tracer clock value */
+} chadfs_trace_rec_t;
+
+/* CHADFS_TRACE_SIGNATURE_V1 trace record (read by replay) */
+typedef struct _chadfs_trace_rec_v1_t {
+	uint8_t			type;
+	uint8_t			op;
+	uint16_t		addresshi;							/* LBA bits 32..47, 0 in traces of CHADFS(32) only builds */
+	uint32_t		address;							/* LBA bits 0..31 */
+	uint64_t		time;
+} chadfs_trace_rec_v1_t;
+#pragma pack(pop)
+
+/* CHADFS tracer (sink for trace records) */
+typedef struct _chadfs_tracer_t {
+	void			(*emit)(void* ctx, const chadfs_trace_rec_t* rec);
+	void*			ctx;								/* passed to emit (OPTIONAL) */
+	uint64_t		(*clock)(void);						/* time source (OPTIONAL) */
+} chadfs_tracer_t;
+
+#endif
@@ -6,20 +6,27 @@
 #include <string.h>
 #include "murmur.h"
 
-#ifndef CHADFS_SECTOR_SIZE
-#define CHADFS_SECTOR_SIZE								512U
-#endif
-#if CHADFS_SECTOR_SIZE % 512 != 0
-#error CHADFS_SECTOR_SIZE % 512 != 0
+/*
+	Largest supported sector, sizes every on-disk struct shared through
+	the API (variant code keeps its own one sector long, see CHADFS_B).
+	Images with 512 and 4096-byte sectors are handled at runtime
+	(mblk.sectorshift), 512 drops 4096 support and keeps the structs one
+	small sector long
+*/
+#ifndef CHADFS_MAX_SECTOR_SIZE
+#define CHADFS_MAX_SECTOR_SIZE							4096U
 #endif
-#if CHADFS_SECTOR_SIZE < 512
-#error CHADFS_SECTOR_SIZE < 512
+#if CHADFS_MAX_SECTOR_SIZE != 512 && CHADFS_MAX_SECTOR_SIZE != 4096
+#error CHADFS_MAX_SECTOR_SIZE != 512 && CHADFS_MAX_SECTOR_SIZE != 4096
 #endif
+#define CHADFS_MIN_SECTOR_SIZE							512U
+#define CHADFS_SECTOR_SIZE_OF(__sshift)					(CHADFS_MIN_SECTOR_SIZE << (__sshift))
 
 /* Seed to generate a file ID by its path */
 #define CHADFS_SEED										0xAB0BA777U
+#define CHADFS_CHECK_SEED								0x5EED1D64U
 
-#define CHADFS_ALIGN_VALUE_UP(__v, __al)				(((__v) + (__al) - 1) & ~((__al) - 1))
+#define CHADFS_ALIGN_VALUE_UP(__v, __al)				(((__v) + (__al) - 1) / (__al) * (__al))
 #define CHADFS_ABS_INDEX(__iIDB, __iE)					(((__iIDB) * CHADFS_NUMOF_IBLK_ENTRIES) + (__iE))
 #define CHADFS_IBLK_INDEX(__iabs)						((__iabs) / CHADFS_NUMOF_IBLK_ENTRIES)
 #define CHADFS_IENTRY_INDEX(__iabs)						((__iabs) % CHADFS_NUMOF_IBLK_ENTRIES)
@@ -39,6 +46,11 @@ typedef enum _chadfs_status_t {
 	CHADFS_STATUS_ZERO_DATA_LEN,
 	CHADFS_STATUS_INVALID_OFFSET,
 	CHADFS_STATUS_NOT_DIR,
+	CHADFS_STATUS_INVALID_CLUSTER_SIZE,
+	CHADFS_STATUS_INVALID_SECTOR_SIZE,
+	CHADFS_STATUS_INVALID_JOURNAL_SIZE,
+	CHADFS_STATUS_NO_JOURNAL,
+	CHADFS_STATUS_BATCH_FULL,
 } chadfs_status_t;
 
 
@@ -70,8 +82,35 @@ typedef struct _chadfs32_dirit_t {
 
 	uint32_t	idirentry;								/* current dir entry index */
 	uint32_t	direntries;								/* num of dir entries */
+	uint8_t		clustershift;							/* volume cluster shift (see chadfs32_vblk_t) */
+	uint8_t		sectorshift;							/* image sector shift (see chadfs32_mblk_t) */
 } chadfs32_dirit_t;
 
+/* CHADFS(64) location */
+typedef struct _chadfs64_loc_t {
+	uint64_t	a;										/* address of sector */
+	void*		d;										/* data (OPTIONAL)*/
+} chadfs64_loc_t;
+
+/* CHADFS(64) extended location */
+typedef struct _chadfs64_eloc_t {
+	uint64_t	a;										/* address of sector */
+	void*		d;										/* data (OPTIONAL)*/
+	uint64_t	i;										/* index */
+} chadfs64_eloc_t;
+
+/* CHADFS(64) directory itertator */
+typedef struct _chadfs64_dirit_t {
+	uint64_t	itbladdr;								/* id table address */
+	uint64_t	dtbladdr;								/* data table address */
+	uint64_t	idcurrent;								/* current chadfs64_idata_t index */
+
+	uint64_t	idirentry;								/* current dir entry index */
+	uint64_t	direntries;								/* num of dir entries */
+	uint8_t		clustershift;							/* volume cluster shift (see chadfs64_vblk_t) */
+	uint8_t		sectorshift;							/* image sector shift (see chadfs64_mblk_t) */
+} chadfs64_dirit_t;
+
 /*
 	Must be implemented by programmer
 */
@@ -90,4 +129,22 @@ void chadfs32_read_sector(
 	void* sectordata
 );
 
+/*
+	Must be implemented by programmer (if CHADFS(64) is used)
+*/
+void chadfs64_write_sector(
+	void* dev,
+	uint64_t address,
+	const void* sectordata
+);
+
+/*
+	Must be implemented by programmer (if CHADFS(64) is used)
+*/
+void chadfs64_read_sector(
+	void* dev,
+	uint64_t address,
+	void* sectordata
+);
+
 #endif
\ No newline at end of file
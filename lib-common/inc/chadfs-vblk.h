@@ -7,16 +7,62 @@
 #define CHADFS_MAX_VOLUME_NAME							31U
 #define CHADFS_TOTAL_BLKS(__viblks)						((__viblks) * CHADFS_NUMOF_IBLK_ENTRIES)
 #define CHADFS_FREE_BLKS(__viblks, __vfblks, __vdblks)	(CHADFS_TOTAL_BLKS(__viblks) - (__vfblks) - (__vdblks))
-/* CHADFS(32) volume block */
-typedef struct _chadfs32_vblk_t {
-	uint8_t			name[CHADFS_MAX_VOLUME_NAME + 1];
-	uint32_t		numiblks;
-	uint32_t		numfblks;
-	uint32_t		numdblks;
-	uint32_t		nextvolume;
+#define CHADFS_MAX_CLUSTER_SIZE							0x100000U
+/* File ids hash the name and the parent dir index instead of the full path (set by add_volume) */
+#define CHADFS_VOLUME_RELATIVE_IDS						0x01U
+/* Id entries keep a second hash of the file in place of the active flag (see chadfs_get_check_hash), set by the caller */
+#define CHADFS_VOLUME_WIDE_IDS							0x02U
+/* Cluster (data table cell) size in bytes, at least one sector */
+#define CHADFS_CLUSTER_SIZE(__clshift)					((uint32_t)CHADFS_MIN_SECTOR_SIZE << (__clshift))
+/* First sector of data table cell `__i` (in sector size variant code) */
+#define CHADFS_CELL_ADDR(__dtaddr, __i, __clshift)		((__dtaddr) + ((__i) << ((__clshift) - CHADFS_SECTOR_SHIFT)))
+/* Num of sectors taken by a volume: vblk, id table, data table (in sector size variant code) */
+#define CHADFS_VOLUME_SECTORS(__viblks, __clshift)		(1 + (__viblks) * (1 + (CHADFS_NUMOF_IBLK_ENTRIES << ((__clshift) - CHADFS_SECTOR_SHIFT))))
+/* CHADFS(32) volume block filling one `__ssize` byte sector (chadfs32_vblk_t - the largest one) */
+#define CHADFS32_VBLK_BODY(__ssize)						\
+{																								\
+	uint8_t			name[CHADFS_MAX_VOLUME_NAME + 1];											\
+	uint32_t		numiblks;																	\
+	uint32_t		numfblks;																	\
+	uint32_t		numdblks;																	\
+	uint32_t		nextvolume;																	\
+	uint8_t			clustershift;						/* cluster = CHADFS_MIN_SECTOR_SIZE << clustershift (at least one sector) */	\
+	uint8_t			sectorshift;						/* copy of mblk.sectorshift (set by add_volume) */	\
+	uint32_t		numjsectors;						/* journal area after the data table (0 - none) */	\
+	uint32_t		reclaimfirst;						/* freed chains waiting for chadfs32_reclaim, linked (0 - none) */	\
+	uint32_t		reclaimlast;																\
+	uint32_t		numreclaim;							/* their cells, still counted in numdblks */	\
+	uint8_t			flags;								/* CHADFS_VOLUME_* */					\
+																								\
+	uint8_t			reserved[(__ssize) - 67];													\
+}
+typedef struct _chadfs32_vblk_t CHADFS32_VBLK_BODY(CHADFS_MAX_SECTOR_SIZE) chadfs32_vblk_t;
 
-	uint8_t			reserved[CHADFS_SECTOR_SIZE - 48];
-} chadfs32_vblk_t;
+/* CHADFS(64) volume block */
+#define CHADFS64_VBLK_BODY(__ssize)						\
+{																								\
+	uint8_t			name[CHADFS_MAX_VOLUME_NAME + 1];											\
+	uint64_t		numiblks;																	\
+	uint64_t		numfblks;																	\
+	uint64_t		numdblks;																	\
+	uint64_t		nextvolume;																	\
+	uint8_t			clustershift;																\
+	uint8_t			sectorshift;																\
+	uint32_t		numjsectors;																\
+	uint64_t		reclaimfirst;																\
+	uint64_t		reclaimlast;																\
+	uint64_t		numreclaim;																	\
+	uint8_t			flags;																		\
+																								\
+	uint8_t			reserved[(__ssize) - 95];													\
+}
+typedef struct _chadfs64_vblk_t CHADFS64_VBLK_BODY(CHADFS_MAX_SECTOR_SIZE) chadfs64_vblk_t;
+
+#if CHADFS_MAX_SECTOR_SIZE > 512
+/* The same for 512-byte sector code (see CHADFS_B) */
+typedef struct _chadfs32_s512_vblk_t CHADFS32_VBLK_BODY(512U) chadfs32_s512_vblk_t;
+typedef struct _chadfs64_s512_vblk_t CHADFS64_VBLK_BODY(512U) chadfs64_s512_vblk_t;
+#endif
 #pragma pack(pop)
 
 #endif
\ No newline at end of file
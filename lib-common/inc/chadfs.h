@@ -6,6 +6,14 @@
 #include "chadfs-iblk.h"
 #include "chadfs-fblk.h"
 #include "chadfs-dirent.h"
+#include "chadfs-stats.h"
+#include "chadfs-trace.h"
+#include "chadfs-discard.h"
+#include "chadfs-stream.h"
+#include "chadfs-journal.h"
+#include "chadfs-batch.h"
+#include "chadfs-defrag.h"
+#include "chadfs-tmpl.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -24,6 +32,16 @@ extern "C" {
 		const chadfs_sv_t* spath
 	);
 
+	uint32_t chadfs_get_name_hash(
+		const chadfs_sv_t* sname,
+		uint64_t iparent
+	);
+
+	uint32_t chadfs_get_check_hash(
+		const chadfs_sv_t* skey,
+		uint64_t iparent
+	);
+
 	bool chadfs_get_volume_name(
 		const chadfs_sv_t* spath,
 		chadfs_sv_t* sname
@@ -44,169 +62,52 @@ extern "C" {
 		const char* str
 	);
 /* ================================================= */
-	bool chadfs32_check_mblk(
-		chadfs32_mblk_t* mblk
+	const char* chadfs_op_to_str(
+		chadfs_op_t op
 	);
 
-	void chadfs32_init_mblk(
-		chadfs32_mblk_t* mblk
-	);
-	
-	chadfs_status_t chadfs32_init_vblk(
-		chadfs32_vblk_t* vblk,
-		const chadfs_sv_t* sname,
-		uint32_t numiblks
-	);
-	
-	chadfs_status_t chadfs32_init_fblk(
-		chadfs32_fblk_t* fblk,
-		const chadfs_sv_t* sname,
-		uint32_t size
-	);
-/* ================================================= */
-	chadfs_status_t chadfs32_find_free_fblk(
-		void* dev,
-		const chadfs32_loc_t* vblkloc,
-		chadfs32_eloc_t* iblkeloc
+	void chadfs_set_stats(
+		chadfs_stats_t* stats
 	);
 
-	chadfs_status_t chadfs32_find_free_dblk(
-		void* dev,
-		const chadfs32_loc_t* vblkloc,
-		chadfs32_eloc_t* iblkeloc
-	);
+	chadfs_stats_t* chadfs_get_stats(void);
 
-	chadfs_status_t chadfs32_find_next_free_dblk(
-		void* dev,
-		const chadfs32_loc_t* vblkloc,
-		uint32_t iprev,
-		chadfs32_eloc_t* iblkeloc
-	);
-/* ================================================= */
-	chadfs_status_t chadfs32_read_mblk(
-		void* dev,
-		uint32_t address,
-		chadfs32_mblk_t* mblk
+	void chadfs_stats_cache_access(
+		bool hit
 	);
 
-	chadfs_status_t chadfs32_read_vblk(
-		void* dev,
-		const chadfs32_loc_t* mblkloc,
-		const chadfs_sv_t* sname,
-		chadfs32_vblk_t* vblk,
-		chadfs32_eloc_t* vblkeloc
+	void chadfs_set_tracer(
+		chadfs_tracer_t* tracer
 	);
 
-	chadfs_status_t chadfs32_read_fblk(
-		void* dev, 
-		const chadfs32_loc_t* mblkloc,
-		const chadfs_sv_t* spath,
-		chadfs32_fblk_t* fblk,
-		chadfs32_eloc_t* fblkeloc,
-		chadfs32_vblk_t* vblk,
-		chadfs32_eloc_t* vblkeloc
-	);
-/* ================================================= */
-	chadfs_status_t chadfs32_write_data(
-		void* dev,
-		const chadfs32_loc_t* vblkloc,
-		const void* data,
-		uint32_t len,
-		chadfs32_eloc_t* firstieloc,
-		chadfs32_eloc_t* lastieloc
-	);
+	chadfs_tracer_t* chadfs_get_tracer(void);
 
-	chadfs_status_t chadfs32_read_data(
-		void* dev,
-		const chadfs32_loc_t* vblkloc,
-		uint32_t ifirstidblk,
-		void* buffer,
-		uint32_t offset,
-		uint32_t len
+	void chadfs_set_journal(
+		chadfs_journal_t* journal
 	);
 
-	chadfs_status_t chadfs32_cut_data(
-		void* dev,
-		const chadfs32_loc_t* vblkloc,
-		uint32_t ifirstidblk,
-		uint32_t offset,
-		chadfs32_eloc_t* lastidblkeloc
-	);
-/* ================================================= */
-	chadfs_status_t chadfs32_create_file(
-		void* dev,
-		const chadfs32_loc_t* mblkloc,
-		const chadfs_sv_t* spath,
-		uint32_t attributes,
-		const void* data,
-		uint32_t len
-	);
-
-	chadfs_status_t chadfs32_create_dir(
-		void* dev,
-		const chadfs32_loc_t* mblkloc,
-		const chadfs_sv_t* spath,
-		uint32_t attributes
-	);
+	chadfs_journal_t* chadfs_get_journal(void);
 
-	chadfs_status_t chadfs32_read_file(
-		void* dev,
-		const chadfs32_loc_t* mblkloc,
-		const chadfs_sv_t* spath,
-		void* buffer,
-		uint32_t offset,
-		uint32_t len
+	void chadfs_set_deferred_free(
+		bool deferred
 	);
 
-	chadfs_status_t chadfs32_append_file(
-		void* dev,
-		const chadfs32_loc_t* mblkloc,
-		const chadfs_sv_t* spath,
-		const void* data,
-		uint32_t len
-	);
-
-	chadfs_status_t chadfs32_trunc_file(
-		void* dev,
-		const chadfs32_loc_t* mblkloc,
-		const chadfs_sv_t* spath,
-		uint32_t len
-	);
+	bool chadfs_get_deferred_free(void);
 
-	chadfs_status_t chadfs32_remove_file(
-		void* dev,
-		const chadfs32_loc_t* mblkloc,
-		const chadfs_sv_t* spath
+	void chadfs_set_discarder(
+		chadfs_discarder_t* discarder
 	);
 
-	chadfs_status_t chadfs32_write_file(
-		void* dev,
-		const chadfs32_loc_t* mblkloc,
-		const chadfs_sv_t* spath,
-		const void* data,
-		uint32_t offset,
-		uint32_t len
-	);
+	chadfs_discarder_t* chadfs_get_discarder(void);
 /* ================================================= */
-	chadfs_status_t chadfs32_add_volume(
-		void* dev,
-		const chadfs32_loc_t* mblkloc,
-		const chadfs32_vblk_t* vblk
-	);
-/* ================================================= */
-	chadfs_status_t chadfs32_create_iter(
-		void* dev,
-		const chadfs32_loc_t* mblkloc,
-		const chadfs_sv_t* spath,
-		chadfs32_dirit_t* iter,
-		chadfs32_fblk_t* firstfblk
-	);
-
-	chadfs_status_t chadfs32_move_iter(
-		void* dev,
-		chadfs32_dirit_t* iter,
-		chadfs32_fblk_t* fblk
-	);
+#pragma push_macro("CHADFS_W")
+#undef CHADFS_W
+#define CHADFS_W										32
+#include "chadfs-api.h"
+#undef CHADFS_W
+#define CHADFS_W										64
+#include "chadfs-api.h"
+#pragma pop_macro("CHADFS_W")
 /* ================================================= */
 #ifdef __cplusplus
 }
@@ -0,0 +1,506 @@
+#include <chadfs.h>
+#include <chadfs-io.h>
+
+/* ================================================= */
+static const char* CHADFS_OP_STRS[] = {
+	"none",
+	"find_free_fblk",
+	"find_free_dblk",
+	"find_next_free_dblk",
+	"read_mblk",
+	"read_vblk",
+	"read_fblk",
+	"write_data",
+	"read_data",
+	"cut_data",
+	"create_file",
+	"create_dir",
+	"read_file",
+	"append_file",
+	"trunc_file",
+	"remove_file",
+	"write_file",
+	"add_volume",
+	"create_iter",
+	"move_iter",
+	"open_reader",
+	"read_chunk",
+	"open_writer",
+	"write_chunk",
+	"close_writer",
+	"begin_journal",
+	"commit_journal",
+	"replay_journals",
+	"commit_batch",
+	"flush_writer",
+	"prealloc_file",
+	"count_fragments",
+	"defrag_step",
+	"reclaim",
+	"punch_hole",
+	"share_file",
+	"copy_file",
+	"rename_file",
+	"remove_tree",
+};
+
+/* per thread on hosted builds, so threads can use the library independently */
+#if __STDC_HOSTED__
+#define CHADFS_TLS										__thread
+#else
+#define CHADFS_TLS
+#endif
+
+static CHADFS_TLS chadfs_stats_t* chadfs_cur_stats = NULL;
+static CHADFS_TLS chadfs_tracer_t* chadfs_cur_tracer = NULL;
+static CHADFS_TLS chadfs_op_t chadfs_cur_op = CHADFS_OP_NONE;
+static CHADFS_TLS uint32_t chadfs_op_depth = 0;
+static CHADFS_TLS chadfs_journal_t* chadfs_cur_journal = NULL;
+static CHADFS_TLS bool chadfs_cur_filedata = false;
+static CHADFS_TLS bool chadfs_cur_deferred = false;
+static CHADFS_TLS chadfs_discarder_t* chadfs_cur_discarder = NULL;
+
+static void chadfs_journal_commit(chadfs_journal_t* journal);
+
+/* ================================================= */
+
+/*
+	Get a pointer to a string representing the operation
+*/
+const char* chadfs_op_to_str(
+	chadfs_op_t op
+) {
+	const size_t numstrs = sizeof(CHADFS_OP_STRS) / sizeof(CHADFS_OP_STRS[0]);
+	if ((size_t)op >= numstrs) return NULL;
+	return CHADFS_OP_STRS[(size_t)op];
+}
+
+/*
+	Start (stats != NULL) or stop (stats == NULL) accounting (for the calling thread)
+*/
+void chadfs_set_stats(
+	chadfs_stats_t* stats
+) {
+	chadfs_cur_stats = stats;
+}
+
+chadfs_stats_t* chadfs_get_stats(void) {
+	return chadfs_cur_stats;
+}
+
+/*
+	Report a cache lookup, called by the device implementation
+*/
+void chadfs_stats_cache_access(
+	bool hit
+) {
+	if (!chadfs_cur_stats) return;
+
+	if (hit) chadfs_cur_stats->ops[chadfs_cur_op].chits += 1;
+	else chadfs_cur_stats->ops[chadfs_cur_op].cmisses += 1;
+}
+
+/*
+	Start (tracer != NULL) or stop (tracer == NULL) recording sector accesses (for the calling thread)
+*/
+void chadfs_set_tracer(
+	chadfs_tracer_t* tracer
+) {
+	chadfs_cur_tracer = tracer;
+}
+
+chadfs_tracer_t* chadfs_get_tracer(void) {
+	return chadfs_cur_tracer;
+}
+
+static void chadfs_trace_access(
+	uint8_t type,
+	uint64_t address
+) {
+	chadfs_trace_rec_t rec;
+	rec.type = type;
+	rec.op = (uint8_t)chadfs_cur_op;
+	memset(rec.reserved, 0, sizeof(rec.reserved));
+	rec.address = address;
+	rec.time = chadfs_cur_tracer->clock ? chadfs_cur_tracer->clock() : 0;
+	chadfs_cur_tracer->emit(chadfs_cur_tracer->ctx, &rec);
+}
+
+/* ================================================= */
+
+chadfs_opscope_t chadfs_op_enter(
+	chadfs_op_t op
+) {
+	chadfs_opscope_t scope = { CHADFS_OP_NONE, 0 };
+	if (chadfs_op_depth++) return scope;
+
+	scope.op = op;
+	chadfs_cur_op = op;
+	if (chadfs_cur_stats) {
+		chadfs_cur_stats->ops[op].calls += 1;
+		if (chadfs_cur_stats->clock) scope.start = chadfs_cur_stats->clock();
+	}
+
+	return scope;
+}
+
+void chadfs_op_leave(
+	chadfs_opscope_t* scope
+) {
+	chadfs_op_depth -= 1;
+	if (scope->op == CHADFS_OP_NONE) return;
+
+	chadfs_cur_op = CHADFS_OP_NONE;
+	if (chadfs_cur_stats && chadfs_cur_stats->clock) {
+		chadfs_cur_stats->ops[scope->op].time += chadfs_cur_stats->clock() - scope->start;
+	}
+
+	/* group commit between operations, so one that fits half of the log is never split */
+	chadfs_journal_t* journal = chadfs_cur_journal;
+	if (journal && journal->count && journal->count >= journal->capacity / 2) chadfs_journal_commit(journal);
+}
+
+void chadfs_op_add_bytes(
+	const chadfs_opscope_t* scope,
+	uint64_t bytes
+) {
+	if (scope->op == CHADFS_OP_NONE || !chadfs_cur_stats) return;
+	chadfs_cur_stats->ops[scope->op].bytes += bytes;
+}
+
+/* ================================================= */
+
+/*
+	Start (journal != NULL) or stop (journal == NULL) logging metadata writes (for the calling thread)
+*/
+void chadfs_set_journal(
+	chadfs_journal_t* journal
+) {
+	chadfs_cur_journal = journal;
+}
+
+chadfs_journal_t* chadfs_get_journal(void) {
+	return chadfs_cur_journal;
+}
+
+/*
+	Queue the chains freed by remove_file/trunc_file on their volume for
+	chadfs32_reclaim instead of freeing them in the call (for the calling thread)
+*/
+void chadfs_set_deferred_free(
+	bool deferred
+) {
+	chadfs_cur_deferred = deferred;
+}
+
+bool chadfs_get_deferred_free(void) {
+	return chadfs_cur_deferred;
+}
+
+/*
+	Report freed sector ranges (discarder != NULL) or not (discarder == NULL)
+	to the device (for the calling thread)
+*/
+void chadfs_set_discarder(
+	chadfs_discarder_t* discarder
+) {
+	chadfs_cur_discarder = discarder;
+}
+
+chadfs_discarder_t* chadfs_get_discarder(void) {
+	return chadfs_cur_discarder;
+}
+
+bool chadfs_io_discard(
+	void* dev,
+	uint64_t address,
+	uint64_t count
+) {
+	if (!chadfs_cur_discarder || !count) return false;
+
+	/* until the commit the device still holds the old metadata pointing at them */
+	chadfs_journal_t* journal = chadfs_cur_journal;
+	if (journal && journal->dev == dev) {
+		/* file data written to them from now on is logged, see chadfs_journal_discard */
+		journal->freed = true;
+		for (uint32_t i = 0; i < journal->numdiscards; ++i) {
+			chadfs_jrange_t* range = &journal->discards[i];
+			if (address + count == range->address) {
+				range->address = address;
+				range->count += count;
+				return false;
+			}
+
+			if (range->address + range->count == address) {
+				range->count += count;
+				return false;
+			}
+		}
+
+		if (journal->numdiscards < CHADFS_JOURNAL_DISCARDS) {
+			journal->discards[journal->numdiscards].address = address;
+			journal->discards[journal->numdiscards].count = count;
+			journal->numdiscards += 1;
+		}
+
+		return false;
+	}
+
+	chadfs_cur_discarder->discard(dev, address, count);
+	return true;
+}
+
+void chadfs_io_note_free(void) {
+	if (chadfs_cur_journal) chadfs_cur_journal->freed = true;
+}
+
+bool chadfs_io_enter_data(
+	bool filedata
+) {
+	bool prev = chadfs_cur_filedata;
+	chadfs_cur_filedata = filedata;
+	return prev;
+}
+
+void chadfs_io_leave_data(
+	bool* prev
+) {
+	chadfs_cur_filedata = *prev;
+}
+
+static void chadfs_journal_commit(
+	chadfs_journal_t* journal
+) {
+	if (journal->version == CHADFS_VERSION64) chadfs64_commit_journal(journal);
+	else chadfs32_commit_journal(journal);
+}
+
+uint32_t chadfs_journal_layout(
+	chadfs_journal_t* journal,
+	void* buffer,
+	size_t size,
+	uint32_t sectorsize,
+	size_t maxcount
+) {
+	/* an address, a sector and up to 4 slots per entry */
+	size_t capacity = size / (sizeof(uint64_t) + sectorsize + 4 * sizeof(uint32_t));
+	if (capacity > maxcount) capacity = maxcount;
+	if (capacity > 0x10000000U) capacity = 0x10000000U;
+
+	uint32_t numslots = 1;
+	while (numslots < 2 * capacity) numslots <<= 1;
+
+	journal->addresses = (uint64_t*)buffer;
+	journal->slots = (uint32_t*)&journal->addresses[capacity];
+	journal->sectors = (uint8_t*)&journal->slots[numslots];
+	journal->numslots = numslots;
+	journal->capacity = (uint32_t)capacity;
+	journal->sectorsize = sectorsize;
+	chadfs_journal_reset(journal);
+	return journal->capacity;
+}
+
+void chadfs_journal_reset(
+	chadfs_journal_t* journal
+) {
+	memset(journal->slots, 0, journal->numslots * sizeof(uint32_t));
+	journal->count = 0;
+	journal->freed = false;
+	journal->numdiscards = 0;
+}
+
+/*
+	Slot of a sector address (holding its entry or empty, linear probing)
+*/
+static uint32_t* chadfs_journal_slot(
+	const chadfs_journal_t* journal,
+	uint64_t address
+) {
+	const uint32_t mask = journal->numslots - 1;
+	uint32_t h = (uint32_t)((address * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+	while (journal->slots[h] && journal->addresses[journal->slots[h] - 1] != address) h = (h + 1) & mask;
+	return &journal->slots[h];
+}
+
+/*
+	Index of the logged copy of a sector (journal->capacity - not logged)
+*/
+static uint32_t chadfs_journal_find(
+	const chadfs_journal_t* journal,
+	uint64_t address
+) {
+	const uint32_t slot = *chadfs_journal_slot(journal, address);
+	return slot ? slot - 1 : journal->capacity;
+}
+
+void chadfs_journal_discard(
+	chadfs_journal_t* journal
+) {
+	chadfs_discarder_t* discarder = chadfs_cur_discarder;
+	for (uint32_t i = 0; i < journal->numdiscards && discarder; ++i) {
+		const uint64_t address = journal->discards[i].address;
+		const uint64_t end = address + journal->discards[i].count;
+
+		/* most ranges hold no logged sector */
+		bool logged = false;
+		for (uint32_t j = 0; j < journal->count && !logged; ++j) logged = journal->addresses[j] - address < end - address;
+		if (!logged) {
+			discarder->discard(journal->dev, address, end - address);
+			continue;
+		}
+
+		uint64_t runstart = address;
+		for (uint64_t a = address; a < end; ++a) {
+			if (chadfs_journal_find(journal, a) == journal->capacity) continue;
+			if (a > runstart) discarder->discard(journal->dev, runstart, a - runstart);
+			runstart = a + 1;
+		}
+
+		if (end > runstart) discarder->discard(journal->dev, runstart, end - runstart);
+	}
+
+	journal->numdiscards = 0;
+}
+
+/*
+	Serve a read from the journal, false - the sector is not logged
+*/
+static bool chadfs_journal_read(
+	void* dev,
+	uint64_t address,
+	void* sectordata
+) {
+	chadfs_journal_t* journal = chadfs_cur_journal;
+	if (journal->dev != dev) return false;
+
+	uint32_t i = chadfs_journal_find(journal, address);
+	if (i == journal->capacity) return false;
+
+	memcpy(sectordata, &journal->sectors[(size_t)i * journal->sectorsize], journal->sectorsize);
+	return true;
+}
+
+/*
+	Log a write, false - it goes to the device (file data is written in
+	place unless cells were freed since the last commit)
+*/
+static bool chadfs_journal_write(
+	void* dev,
+	uint64_t address,
+	const void* sectordata,
+	bool data
+) {
+	chadfs_journal_t* journal = chadfs_cur_journal;
+	if (journal->dev != dev) return false;
+
+	uint32_t i = chadfs_journal_find(journal, address);
+	if (data && chadfs_cur_filedata && !journal->freed) {
+		/* an older logged copy is kept current, the commit writes the same data */
+		if (i != journal->capacity) memcpy(&journal->sectors[(size_t)i * journal->sectorsize], sectordata, journal->sectorsize);
+
+		/* a replay of the checkpointed record could hit this sector */
+		if (journal->clearing) {
+			if (journal->flush) journal->flush(dev);
+			journal->clearing = false;
+		}
+
+		return false;
+	}
+
+	if (i == journal->capacity) {
+		if (journal->count == journal->capacity) {
+			/* the operation is half done, its freed cells may still be in use on disk */
+			journal->numdiscards = 0;
+			chadfs_journal_commit(journal);
+		}
+
+		i = journal->count++;
+		journal->addresses[i] = address;
+		*chadfs_journal_slot(journal, address) = i + 1;
+	}
+
+	memcpy(&journal->sectors[(size_t)i * journal->sectorsize], sectordata, journal->sectorsize);
+	return true;
+}
+
+/* ================================================= */
+
+static void chadfs32_dev_write_sector(
+	void* dev,
+	uint32_t address,
+	const void* sectordata
+) {
+	if (chadfs_cur_stats) chadfs_cur_stats->ops[chadfs_cur_op].swrites += 1;
+	if (chadfs_cur_tracer) chadfs_trace_access(CHADFS_TRACE_WRITE, address);
+	chadfs32_write_sector(dev, address, sectordata);
+}
+
+void chadfs32_io_read_sector(
+	void* dev,
+	uint32_t address,
+	void* sectordata
+) {
+	if (chadfs_cur_journal && chadfs_journal_read(dev, address, sectordata)) return;
+	if (chadfs_cur_stats) chadfs_cur_stats->ops[chadfs_cur_op].sreads += 1;
+	if (chadfs_cur_tracer) chadfs_trace_access(CHADFS_TRACE_READ, address);
+	chadfs32_read_sector(dev, address, sectordata);
+}
+
+void chadfs32_io_write_sector(
+	void* dev,
+	uint32_t address,
+	const void* sectordata
+) {
+	if (chadfs_cur_journal && chadfs_journal_write(dev, address, sectordata, false)) return;
+	chadfs32_dev_write_sector(dev, address, sectordata);
+}
+
+void chadfs32_io_write_data(
+	void* dev,
+	uint32_t address,
+	const void* sectordata
+) {
+	if (chadfs_cur_journal && chadfs_journal_write(dev, address, sectordata, true)) return;
+	chadfs32_dev_write_sector(dev, address, sectordata);
+}
+
+static void chadfs64_dev_write_sector(
+	void* dev,
+	uint64_t address,
+	const void* sectordata
+) {
+	if (chadfs_cur_stats) chadfs_cur_stats->ops[chadfs_cur_op].swrites += 1;
+	if (chadfs_cur_tracer) chadfs_trace_access(CHADFS_TRACE_WRITE, address);
+	chadfs64_write_sector(dev, address, sectordata);
+}
+
+void chadfs64_io_read_sector(
+	void* dev,
+	uint64_t address,
+	void* sectordata
+) {
+	if (chadfs_cur_journal && chadfs_journal_read(dev, address, sectordata)) return;
+	if (chadfs_cur_stats) chadfs_cur_stats->ops[chadfs_cur_op].sreads += 1;
+	if (chadfs_cur_tracer) chadfs_trace_access(CHADFS_TRACE_READ, address);
+	chadfs64_read_sector(dev, address, sectordata);
+}
+
+void chadfs64_io_write_sector(
+	void* dev,
+	uint64_t address,
+	const void* sectordata
+) {
+	if (chadfs_cur_journal && chadfs_journal_write(dev, address, sectordata, false)) return;
+	chadfs64_dev_write_sector(dev, address, sectordata);
+}
+
+void chadfs64_io_write_data(
+	void* dev,
+	uint64_t address,
+	const void* sectordata
+) {
+	if (chadfs_cur_journal && chadfs_journal_write(dev, address, sectordata, true)) return;
+	chadfs64_dev_write_sector(dev, address, sectordata);
+}
+
+/* ================================================= */
@@ -0,0 +1,160 @@
+#include <chadfs-lz.h>
+#include <string.h>
+
+/*
+	LZ4 block format: sequences of a token (literal length << 4 | match
+	length - 4, 15 - continued in bytes of 255 until a smaller one), the
+	literals, a little endian 16 bit match offset and the match length
+	continuation. The last sequence has literals only
+*/
+#define CHADFS_LZ_HASH_LOG								12U
+#define CHADFS_LZ_MIN_MATCH								4U
+#define CHADFS_LZ_LAST_LITERALS							5U		/* no match reaches into the last bytes */
+#define CHADFS_LZ_MF_LIMIT								12U		/* nor starts in the last bytes */
+#define CHADFS_LZ_SKIP_TRIGGER							6U		/* misses before the search steps faster */
+
+static inline uint32_t chadfs_lz_read32(const uint8_t* p) {
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline uint32_t chadfs_lz_hash(uint32_t v) {
+	return (v * 2654435761U) >> (32U - CHADFS_LZ_HASH_LOG);
+}
+
+/* Length continuation bytes of a token nibble */
+static inline size_t chadfs_lz_put_len(uint8_t* out, size_t len) {
+	size_t n = 0;
+	for (; len >= 255; len -= 255) out[n++] = 255;
+	out[n++] = (uint8_t)len;
+	return n;
+}
+
+size_t chadfs_lz_compress(
+	const void* src,
+	size_t len,
+	void* dst,
+	size_t cap
+) {
+	const uint8_t* in = (const uint8_t*)src;
+	uint8_t* out = (uint8_t*)dst;
+	if (!len || len > CHADFS_LZ_MAX_INPUT) return 0;
+
+	/* positions + 1 of the last 4 byte sequences per hash (0 - none) */
+	uint16_t table[1U << CHADFS_LZ_HASH_LOG];
+	memset(table, 0, sizeof(table));
+
+	size_t ip = 0;
+	size_t op = 0;
+	size_t anchor = 0;
+	size_t misses = 0;
+	if (len > CHADFS_LZ_MF_LIMIT) {
+		const size_t mflimit = len - CHADFS_LZ_MF_LIMIT;
+		const size_t matchlimit = len - CHADFS_LZ_LAST_LITERALS;
+		while (ip < mflimit) {
+			const uint32_t seq = chadfs_lz_read32(&in[ip]);
+			const uint32_t h = chadfs_lz_hash(seq);
+			const size_t ref = table[h];
+			table[h] = (uint16_t)(ip + 1);
+			if (!ref || chadfs_lz_read32(&in[ref - 1]) != seq) {
+				ip += 1 + (misses++ >> CHADFS_LZ_SKIP_TRIGGER);
+				continue;
+			}
+
+			size_t mp = ref - 1;
+			while (ip > anchor && mp && in[ip - 1] == in[mp - 1]) {
+				ip -= 1;
+				mp -= 1;
+			}
+
+			size_t mlen = CHADFS_LZ_MIN_MATCH;
+			while (ip + mlen < matchlimit && in[ip + mlen] == in[mp + mlen]) mlen += 1;
+
+			const size_t lit = ip - anchor;
+			if (op + 1 + lit + lit / 255 + 1 + 2 + mlen / 255 + 1 > cap) return 0;
+
+			uint8_t* token = &out[op++];
+			*token = (uint8_t)((lit < 15 ? lit : 15) << 4);
+			if (lit >= 15) op += chadfs_lz_put_len(&out[op], lit - 15);
+			memcpy(&out[op], &in[anchor], lit);
+			op += lit;
+
+			const size_t offset = ip - mp;
+			out[op++] = (uint8_t)offset;
+			out[op++] = (uint8_t)(offset >> 8);
+
+			const size_t mcode = mlen - CHADFS_LZ_MIN_MATCH;
+			*token |= (uint8_t)(mcode < 15 ? mcode : 15);
+			if (mcode >= 15) op += chadfs_lz_put_len(&out[op], mcode - 15);
+
+			ip += mlen;
+			anchor = ip;
+			misses = 0;
+			if (ip < mflimit) table[chadfs_lz_hash(chadfs_lz_read32(&in[ip - 2]))] = (uint16_t)(ip - 1);
+		}
+	}
+
+	const size_t lit = len - anchor;
+	if (op + 1 + lit + lit / 255 + 1 > cap) return 0;
+
+	out[op++] = (uint8_t)((lit < 15 ? lit : 15) << 4);
+	if (lit >= 15) op += chadfs_lz_put_len(&out[op], lit - 15);
+	memcpy(&out[op], &in[anchor], lit);
+	return op + lit;
+}
+
+size_t chadfs_lz_decompress(
+	const void* src,
+	size_t len,
+	void* dst,
+	size_t cap
+) {
+	const uint8_t* in = (const uint8_t*)src;
+	uint8_t* out = (uint8_t*)dst;
+	size_t ip = 0;
+	size_t op = 0;
+	while (ip < len) {
+		const uint8_t token = in[ip++];
+		size_t lit = token >> 4;
+		if (lit == 15) {
+			uint8_t b;
+			do {
+				if (ip >= len) return CHADFS_LZ_ERROR;
+				b = in[ip++];
+				lit += b;
+			} while (b == 255);
+		}
+
+		if (lit > len - ip || lit > cap - op) return CHADFS_LZ_ERROR;
+		memcpy(&out[op], &in[ip], lit);
+		ip += lit;
+		op += lit;
+		if (ip == len) return op;
+
+		if (len - ip < 2) return CHADFS_LZ_ERROR;
+		const size_t offset = (size_t)in[ip] | (size_t)in[ip + 1] << 8;
+		ip += 2;
+		if (!offset || offset > op) return CHADFS_LZ_ERROR;
+
+		size_t mlen = token & 15U;
+		if (mlen == 15) {
+			uint8_t b;
+			do {
+				if (ip >= len) return CHADFS_LZ_ERROR;
+				b = in[ip++];
+				mlen += b;
+			} while (b == 255);
+		}
+
+		mlen += CHADFS_LZ_MIN_MATCH;
+		if (mlen > cap - op) return CHADFS_LZ_ERROR;
+
+		/* the match may overlap what it produces, byte by byte */
+		const uint8_t* match = &out[op - offset];
+		for (size_t i = 0; i < mlen; ++i) out[op + i] = match[i];
+		op += mlen;
+	}
+
+	return CHADFS_LZ_ERROR;
+}
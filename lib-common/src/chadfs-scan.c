@@ -0,0 +1,319 @@
+#include <chadfs-scan.h>
+#include <stdbool.h>
+
+/*
+	SSE2/AVX2 kernels are built with target attributes and chosen by
+	CPUID at run time, so the rest of the library keeps the base ISA
+*/
+#if __STDC_HOSTED__ && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CHADFS_SCAN_X86
+#include <immintrin.h>
+#endif
+
+/* shared by all threads, only ever changes to a supported level (see chadfs_get_scan_isa) */
+static chadfs_scan_isa_t scanisa = CHADFS_SCAN_AUTO;
+
+static chadfs_scan_isa_t chadfs_scan_best_isa(void) {
+#ifdef CHADFS_SCAN_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) return CHADFS_SCAN_AVX2;
+	if (__builtin_cpu_supports("sse2")) return CHADFS_SCAN_SSE2;
+#endif
+	return CHADFS_SCAN_SCALAR;
+}
+
+chadfs_scan_isa_t chadfs_set_scan_isa(
+	chadfs_scan_isa_t isa
+) {
+	const chadfs_scan_isa_t best = chadfs_scan_best_isa();
+	if (isa == CHADFS_SCAN_AUTO || isa > best) isa = best;
+	__atomic_store_n(&scanisa, isa, __ATOMIC_RELAXED);
+	return isa;
+}
+
+chadfs_scan_isa_t chadfs_get_scan_isa(void) {
+	chadfs_scan_isa_t isa = __atomic_load_n(&scanisa, __ATOMIC_RELAXED);
+	if (isa != CHADFS_SCAN_AUTO) return isa;
+
+	/* the first caller resolves it, a level set meanwhile is kept */
+	const chadfs_scan_isa_t best = chadfs_scan_best_isa();
+	if (__atomic_compare_exchange_n(&scanisa, &isa, best, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) return best;
+	return isa;
+}
+
+const char* chadfs_scan_isa_str(
+	chadfs_scan_isa_t isa
+) {
+	switch (isa) {
+	case CHADFS_SCAN_SCALAR: return "scalar";
+	case CHADFS_SCAN_SSE2: return "sse2";
+	case CHADFS_SCAN_AVX2: return "avx2";
+	default: return "auto";
+	}
+}
+
+/* ================================================= */
+
+static uint32_t chadfs32_scan_pairs_scalar(
+	const uint32_t* e,
+	uint32_t i,
+	uint32_t count,
+	uint32_t first,
+	uint32_t second
+) {
+	for (; i < count; ++i) {
+		if (e[2 * i] == first && e[2 * i + 1] == second) break;
+	}
+
+	return i;
+}
+
+static uint32_t chadfs64_scan_pairs_scalar(
+	const uint64_t* e,
+	uint32_t i,
+	uint32_t count,
+	uint64_t first,
+	uint64_t second
+) {
+	for (; i < count; ++i) {
+		if (e[2 * i] == first && e[2 * i + 1] == second) break;
+	}
+
+	return i;
+}
+
+static uint32_t chadfs32_rscan_zero_scalar(
+	const uint32_t* e,
+	uint32_t i
+) {
+	while (i) {
+		--i;
+		if (!e[2 * i]) return i;
+	}
+
+	return CHADFS_SCAN_NONE;
+}
+
+static uint32_t chadfs64_rscan_zero_scalar(
+	const uint64_t* e,
+	uint32_t i
+) {
+	while (i) {
+		--i;
+		if (!e[2 * i]) return i;
+	}
+
+	return CHADFS_SCAN_NONE;
+}
+
+#ifdef CHADFS_SCAN_X86
+
+/*
+	Compare masks hold one bit per 32-bit (ps) or 64-bit (pd) lane, an
+	entry matches when all lanes of its words do
+*/
+__attribute__((target("sse2")))
+static uint32_t chadfs32_scan_pairs_sse2(
+	const uint32_t* e,
+	uint32_t i,
+	uint32_t count,
+	uint32_t first,
+	uint32_t second
+) {
+	const __m128i key = _mm_set_epi32((int)second, (int)first, (int)second, (int)first);
+	for (; i + 8 <= count; i += 8) {
+		const __m128i* p = (const __m128i*)(e + 2 * i);
+		__m128i c0 = _mm_cmpeq_epi32(_mm_loadu_si128(p), key);
+		__m128i c1 = _mm_cmpeq_epi32(_mm_loadu_si128(p + 1), key);
+		__m128i c2 = _mm_cmpeq_epi32(_mm_loadu_si128(p + 2), key);
+		__m128i c3 = _mm_cmpeq_epi32(_mm_loadu_si128(p + 3), key);
+
+		/* both words of an entry (lanes swapped in pairs) */
+		c0 = _mm_and_si128(c0, _mm_shuffle_epi32(c0, 0xB1));
+		c1 = _mm_and_si128(c1, _mm_shuffle_epi32(c1, 0xB1));
+		c2 = _mm_and_si128(c2, _mm_shuffle_epi32(c2, 0xB1));
+		c3 = _mm_and_si128(c3, _mm_shuffle_epi32(c3, 0xB1));
+		if (!_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(c0, c1), _mm_or_si128(c2, c3)))) continue;
+
+		const uint32_t m = (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(c0))
+			| (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(c1)) << 4
+			| (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(c2)) << 8
+			| (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(c3)) << 12;
+		return i + ((uint32_t)__builtin_ctz(m) >> 1);
+	}
+
+	return chadfs32_scan_pairs_scalar(e, i, count, first, second);
+}
+
+__attribute__((target("avx2")))
+static uint32_t chadfs32_scan_pairs_avx2(
+	const uint32_t* e,
+	uint32_t i,
+	uint32_t count,
+	uint32_t first,
+	uint32_t second
+) {
+	/* an entry is one little endian 64-bit lane */
+	const __m256i key = _mm256_set1_epi64x((long long)((uint64_t)second << 32 | first));
+	for (; i + 8 <= count; i += 8) {
+		const __m256i* p = (const __m256i*)(e + 2 * i);
+		const __m256i c0 = _mm256_cmpeq_epi64(_mm256_loadu_si256(p), key);
+		const __m256i c1 = _mm256_cmpeq_epi64(_mm256_loadu_si256(p + 1), key);
+		const uint32_t m = (uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(c0))
+			| (uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(c1)) << 4;
+		if (m) return i + (uint32_t)__builtin_ctz(m);
+	}
+
+	return chadfs32_scan_pairs_scalar(e, i, count, first, second);
+}
+
+__attribute__((target("avx2")))
+static uint32_t chadfs64_scan_pairs_avx2(
+	const uint64_t* e,
+	uint32_t i,
+	uint32_t count,
+	uint64_t first,
+	uint64_t second
+) {
+	const __m256i key = _mm256_set_epi64x((long long)second, (long long)first, (long long)second, (long long)first);
+	for (; i + 8 <= count; i += 8) {
+		const __m256i* p = (const __m256i*)(e + 2 * i);
+		const __m256i c0 = _mm256_cmpeq_epi64(_mm256_loadu_si256(p), key);
+		const __m256i c1 = _mm256_cmpeq_epi64(_mm256_loadu_si256(p + 1), key);
+		const __m256i c2 = _mm256_cmpeq_epi64(_mm256_loadu_si256(p + 2), key);
+		const __m256i c3 = _mm256_cmpeq_epi64(_mm256_loadu_si256(p + 3), key);
+		uint32_t m = (uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(c0))
+			| (uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(c1)) << 4
+			| (uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(c2)) << 8
+			| (uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(c3)) << 12;
+		m &= m >> 1;
+		m &= 0x5555U;
+		if (m) return i + ((uint32_t)__builtin_ctz(m) >> 1);
+	}
+
+	return chadfs64_scan_pairs_scalar(e, i, count, first, second);
+}
+
+/*
+	Reverse scans look at the blocks below `i` and take the highest
+	matching first word
+*/
+__attribute__((target("sse2")))
+static uint32_t chadfs32_rscan_zero_sse2(
+	const uint32_t* e,
+	uint32_t i
+) {
+	const __m128i zero = _mm_setzero_si128();
+	for (; i >= 4; i -= 4) {
+		const __m128i* p = (const __m128i*)(e + 2 * (i - 4));
+		uint32_t m = (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_loadu_si128(p), zero)))
+			| (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_loadu_si128(p + 1), zero))) << 4;
+		m &= 0x55U;
+		if (m) return i - 4 + ((31U - (uint32_t)__builtin_clz(m)) >> 1);
+	}
+
+	return chadfs32_rscan_zero_scalar(e, i);
+}
+
+__attribute__((target("avx2")))
+static uint32_t chadfs32_rscan_zero_avx2(
+	const uint32_t* e,
+	uint32_t i
+) {
+	const __m256i zero = _mm256_setzero_si256();
+	for (; i >= 8; i -= 8) {
+		const __m256i* p = (const __m256i*)(e + 2 * (i - 8));
+		uint32_t m = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_loadu_si256(p), zero)))
+			| (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_loadu_si256(p + 1), zero))) << 8;
+		m &= 0x5555U;
+		if (m) return i - 8 + ((31U - (uint32_t)__builtin_clz(m)) >> 1);
+	}
+
+	return chadfs32_rscan_zero_scalar(e, i);
+}
+
+__attribute__((target("avx2")))
+static uint32_t chadfs64_rscan_zero_avx2(
+	const uint64_t* e,
+	uint32_t i
+) {
+	const __m256i zero = _mm256_setzero_si256();
+	for (; i >= 4; i -= 4) {
+		const __m256i* p = (const __m256i*)(e + 2 * (i - 4));
+		uint32_t m = (uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_loadu_si256(p), zero)))
+			| (uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_loadu_si256(p + 1), zero))) << 4;
+		m &= 0x55U;
+		if (m) return i - 4 + ((31U - (uint32_t)__builtin_clz(m)) >> 1);
+	}
+
+	return chadfs64_rscan_zero_scalar(e, i);
+}
+
+#endif
+
+/* ================================================= */
+
+uint32_t chadfs32_scan_pairs(
+	const void* entries,
+	uint32_t ifrom,
+	uint32_t count,
+	uint32_t first,
+	uint32_t second
+) {
+	const uint32_t* e = (const uint32_t*)entries;
+#ifdef CHADFS_SCAN_X86
+	switch (chadfs_get_scan_isa()) {
+	case CHADFS_SCAN_AVX2: return chadfs32_scan_pairs_avx2(e, ifrom, count, first, second);
+	case CHADFS_SCAN_SSE2: return chadfs32_scan_pairs_sse2(e, ifrom, count, first, second);
+	default: break;
+	}
+#endif
+	return chadfs32_scan_pairs_scalar(e, ifrom, count, first, second);
+}
+
+/* an SSE2 vector holds one CHADFS(64) entry, no faster than the 64-bit compares */
+uint32_t chadfs64_scan_pairs(
+	const void* entries,
+	uint32_t ifrom,
+	uint32_t count,
+	uint64_t first,
+	uint64_t second
+) {
+	const uint64_t* e = (const uint64_t*)entries;
+#ifdef CHADFS_SCAN_X86
+	switch (chadfs_get_scan_isa()) {
+	case CHADFS_SCAN_AVX2: return chadfs64_scan_pairs_avx2(e, ifrom, count, first, second);
+	default: break;
+	}
+#endif
+	return chadfs64_scan_pairs_scalar(e, ifrom, count, first, second);
+}
+
+uint32_t chadfs32_rscan_zero(
+	const void* entries,
+	uint32_t count
+) {
+	const uint32_t* e = (const uint32_t*)entries;
+#ifdef CHADFS_SCAN_X86
+	switch (chadfs_get_scan_isa()) {
+	case CHADFS_SCAN_AVX2: return chadfs32_rscan_zero_avx2(e, count);
+	case CHADFS_SCAN_SSE2: return chadfs32_rscan_zero_sse2(e, count);
+	default: break;
+	}
+#endif
+	return chadfs32_rscan_zero_scalar(e, count);
+}
+
+uint32_t chadfs64_rscan_zero(
+	const void* entries,
+	uint32_t count
+) {
+	const uint64_t* e = (const uint64_t*)entries;
+#ifdef CHADFS_SCAN_X86
+	switch (chadfs_get_scan_isa()) {
+	case CHADFS_SCAN_AVX2: return chadfs64_rscan_zero_avx2(e, count);
+	default: break;
+	}
+#endif
+	return chadfs64_rscan_zero_scalar(e, count);
+}
@@ -0,0 +1,10 @@
+#include <chadfs.h>
+#include <chadfs-io.h>
+#include <chadfs-lz.h>
+#include <chadfs-scan.h>
+
+/* CHADFS(64) */
+#define CHADFS_W										64
+#include <chadfs-tmpl.h>
+
+#include "chadfs-width.inc"
@@ -0,0 +1,12 @@
+#include <dirent.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "ut.h"
+
+/* CHADFS(32) */
+#define CHADFS_W										32
+#include <chadfs-tmpl.h>
+
+#include "act.inc"
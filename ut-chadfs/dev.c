@@ -0,0 +1,337 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include "dev.h"
+
+static void dev_panic(const char* what, uint64_t address) {
+	fprintf(stderr, "%s (lba=0x%llx)!\n", what, (unsigned long long)address);
+	exit(-1);
+}
+
+/* ========================================= */
+
+static void backend_read(ut_dev_t* dev, uint64_t address, void* sectordata) {
+	dev->breads += 1;
+	if (!dev->f) {
+		if (address < dev->ramsectors) memcpy(sectordata, &dev->ram[(size_t)address * dev->sectorsize], dev->sectorsize);
+		else memset(sectordata, 0, dev->sectorsize);
+		return;
+	}
+
+	if (fseeko(dev->f, (off_t)(address * dev->sectorsize), SEEK_SET)) dev_panic("fseeko(...) != 0", address);
+	if (fread(sectordata, dev->sectorsize, 1, dev->f) != 1) dev_panic("fread(...) != 1", address);
+}
+
+static void backend_write(ut_dev_t* dev, uint64_t address, const void* sectordata) {
+	dev->bwrites += 1;
+	if (!dev->f) {
+		if (address >= dev->ramsectors) {
+			uint64_t newsectors = dev->ramsectors ? dev->ramsectors : 64;
+			while (newsectors <= address) newsectors *= 2;
+
+			uint8_t* newram = (uint8_t*)realloc(dev->ram, (size_t)newsectors * dev->sectorsize);
+			if (!newram) dev_panic("Not enough memory", address);
+
+			memset(&newram[(size_t)dev->ramsectors * dev->sectorsize], 0, (size_t)(newsectors - dev->ramsectors) * dev->sectorsize);
+			dev->ram = newram;
+			dev->ramsectors = newsectors;
+		}
+
+		memcpy(&dev->ram[(size_t)address * dev->sectorsize], sectordata, dev->sectorsize);
+		return;
+	}
+
+	if (fseeko(dev->f, (off_t)(address * dev->sectorsize), SEEK_SET)) dev_panic("fseeko(...) != 0", address);
+	if (fwrite(sectordata, dev->sectorsize, 1, dev->f) != 1) dev_panic("fwrite(...) != 1", address);
+}
+
+/*
+	Drop `count` sectors from `address`: a hole in the image file (zeros
+	written where punching is not supported) or zeros in RAM
+*/
+static void backend_discard(ut_dev_t* dev, uint64_t address, uint64_t count) {
+	if (!dev->f) {
+		if (address >= dev->ramsectors) return;
+		if (count > dev->ramsectors - address) count = dev->ramsectors - address;
+		memset(&dev->ram[(size_t)address * dev->sectorsize], 0, (size_t)count * dev->sectorsize);
+		return;
+	}
+
+	/* buffered writes must not land after the hole is punched */
+	fflush(dev->f);
+
+	struct stat st;
+	if (fstat(fileno(dev->f), &st)) dev_panic("fstat(...) != 0", address);
+
+	const uint64_t filesectors = (uint64_t)st.st_size / dev->sectorsize;
+	if (address >= filesectors) return;
+	if (count > filesectors - address) count = filesectors - address;
+
+#ifdef FALLOC_FL_PUNCH_HOLE
+	const int mode = FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE;
+	if (!fallocate(fileno(dev->f), mode, (off_t)(address * dev->sectorsize), (off_t)(count * dev->sectorsize))) return;
+#endif
+
+	uint8_t* zeros = (uint8_t*)calloc(1, dev->sectorsize);
+	if (!zeros) dev_panic("Not enough memory", address);
+
+	for (uint64_t i = 0; i < count; ++i) backend_write(dev, address + i, zeros);
+	free(zeros);
+}
+
+/* ========================================= */
+
+static uint32_t cache_hash(const ut_dev_t* dev, uint64_t address) {
+	return ((uint32_t)(address ^ (address >> 32)) * 0x9E3779B1U) & (dev->numbuckets - 1);
+}
+
+static void lru_unlink(ut_dev_t* dev, ut_cline_t* line) {
+	if (line->prev) line->prev->next = line->next;
+	else dev->head = line->next;
+	if (line->next) line->next->prev = line->prev;
+	else dev->tail = line->prev;
+}
+
+static void lru_push(ut_dev_t* dev, ut_cline_t* line) {
+	line->prev = NULL;
+	line->next = dev->head;
+	if (dev->head) dev->head->prev = line;
+	else dev->tail = line;
+	dev->head = line;
+}
+
+static ut_cline_t* cache_find(ut_dev_t* dev, uint64_t address) {
+	ut_cline_t* line = dev->buckets[cache_hash(dev, address)];
+	while (line && line->address != address) line = line->hnext;
+	return line;
+}
+
+static void cache_unhash(ut_dev_t* dev, ut_cline_t* line) {
+	ut_cline_t** pline = &dev->buckets[cache_hash(dev, line->address)];
+	while (*pline != line) pline = &(*pline)->hnext;
+	*pline = line->hnext;
+}
+
+/*
+	Get a line for `address` (free one or evicted LRU one)
+*/
+static ut_cline_t* cache_take(ut_dev_t* dev, uint64_t address) {
+	ut_cline_t* line;
+	if (dev->usedlines < dev->numlines) line = &dev->lines[dev->usedlines++];
+	else {
+		line = dev->tail;
+		lru_unlink(dev, line);
+		cache_unhash(dev, line);
+		if (line->dirty) backend_write(dev, line->address, line->data);
+	}
+
+	uint32_t ibucket = cache_hash(dev, address);
+	line->address = address;
+	line->dirty = false;
+	line->hnext = dev->buckets[ibucket];
+	dev->buckets[ibucket] = line;
+	lru_push(dev, line);
+	return line;
+}
+
+static int cmp_lines(const void* a, const void* b) {
+	uint64_t aa = (*(ut_cline_t* const*)a)->address;
+	uint64_t ba = (*(ut_cline_t* const*)b)->address;
+	return (aa > ba) - (aa < ba);
+}
+
+/* ========================================= */
+
+static void cache_alloc(ut_dev_t* dev, uint32_t cachesectors) {
+	if (!cachesectors) return;
+
+	dev->numbuckets = 1;
+	while (dev->numbuckets < cachesectors) dev->numbuckets <<= 1;
+
+	dev->lines = (ut_cline_t*)malloc((size_t)cachesectors * sizeof(ut_cline_t));
+	dev->buckets = (ut_cline_t**)calloc(dev->numbuckets, sizeof(ut_cline_t*));
+	dev->linedata = (uint8_t*)malloc((size_t)cachesectors * dev->sectorsize);
+	if (!dev->lines || !dev->buckets || !dev->linedata) {
+		fprintf(stderr, "Not enough memory!\n");
+		exit(-1);
+	}
+
+	for (uint32_t i = 0; i < cachesectors; ++i) dev->lines[i].data = &dev->linedata[(size_t)i * dev->sectorsize];
+	dev->numlines = cachesectors;
+}
+
+static void cache_free(ut_dev_t* dev) {
+	free(dev->lines);
+	free(dev->buckets);
+	free(dev->linedata);
+	dev->lines = NULL;
+	dev->buckets = NULL;
+	dev->linedata = NULL;
+	dev->head = NULL;
+	dev->tail = NULL;
+	dev->numlines = 0;
+	dev->usedlines = 0;
+	dev->numbuckets = 0;
+}
+
+static void dev_init(ut_dev_t* dev, uint32_t sectorsize, uint32_t cachesectors) {
+	memset(dev, 0, sizeof(*dev));
+	dev->sectorsize = sectorsize;
+	cache_alloc(dev, cachesectors);
+}
+
+void ut_dev_init_file(ut_dev_t* dev, FILE* f, uint32_t sectorsize, uint32_t cachesectors) {
+	dev_init(dev, sectorsize, cachesectors);
+	dev->f = f;
+}
+
+void ut_dev_init_ram(ut_dev_t* dev, uint32_t sectorsize, uint32_t cachesectors) {
+	dev_init(dev, sectorsize, cachesectors);
+}
+
+/*
+	Switch to another sector size (e.g. after reading the mblk with
+	the minimal one), the cache is written back and rebuilt
+*/
+void ut_dev_set_sector_size(ut_dev_t* dev, uint32_t sectorsize) {
+	if (sectorsize == dev->sectorsize) return;
+
+	uint32_t cachesectors = dev->numlines;
+	ut_dev_flush(dev);
+	cache_free(dev);
+
+	dev->ramsectors = dev->ramsectors * dev->sectorsize / sectorsize;
+	dev->sectorsize = sectorsize;
+	cache_alloc(dev, cachesectors);
+}
+
+/*
+	Write back dirty sectors in LBA order
+*/
+void ut_dev_flush(ut_dev_t* dev) {
+	if (!dev->usedlines) return;
+
+	ut_cline_t** dirty = (ut_cline_t**)malloc((size_t)dev->usedlines * sizeof(ut_cline_t*));
+	if (!dirty) {
+		fprintf(stderr, "Not enough memory!\n");
+		exit(-1);
+	}
+
+	size_t numdirty = 0;
+	for (uint32_t i = 0; i < dev->usedlines; ++i) if (dev->lines[i].dirty) dirty[numdirty++] = &dev->lines[i];
+	qsort(dirty, numdirty, sizeof(ut_cline_t*), cmp_lines);
+
+	for (size_t i = 0; i < numdirty; ++i) {
+		backend_write(dev, dirty[i]->address, dirty[i]->data);
+		dirty[i]->dirty = false;
+	}
+
+	free(dirty);
+	if (dev->f) fflush(dev->f);
+}
+
+/*
+	Write back and wait for the backend (journal barrier)
+*/
+void ut_dev_sync(void* dev) {
+	ut_dev_t* d = (ut_dev_t*)dev;
+	ut_dev_flush(d);
+	if (d->f) fsync(fileno(d->f));
+}
+
+/*
+	Discarder of the image (chadfs_discarder_t), cached copies of the
+	sectors turn into clean zeroed lines
+*/
+void ut_dev_discard(void* dev, uint64_t address, uint64_t count) {
+	ut_dev_t* d = (ut_dev_t*)dev;
+	if (count <= d->usedlines) {
+		for (uint64_t i = 0; i < count; ++i) {
+			ut_cline_t* line = cache_find(d, address + i);
+			if (!line) continue;
+
+			memset(line->data, 0, d->sectorsize);
+			line->dirty = false;
+		}
+	}
+	else {
+		for (uint32_t i = 0; i < d->usedlines; ++i) {
+			ut_cline_t* line = &d->lines[i];
+			if (line->address < address || line->address - address >= count) continue;
+
+			memset(line->data, 0, d->sectorsize);
+			line->dirty = false;
+		}
+	}
+
+	backend_discard(d, address, count);
+}
+
+void ut_dev_close(ut_dev_t* dev) {
+	ut_dev_flush(dev);
+	if (dev->f) fclose(dev->f);
+
+	cache_free(dev);
+	free(dev->ram);
+	memset(dev, 0, sizeof(*dev));
+}
+
+/* ========================================= */
+
+void chadfs64_write_sector(void* dev, uint64_t address, const void* sectordata) {
+	ut_dev_t* d = (ut_dev_t*)dev;
+	if (!d->numlines) {
+		backend_write(d, address, sectordata);
+		return;
+	}
+
+	ut_cline_t* line = cache_find(d, address);
+	chadfs_stats_cache_access(line != NULL);
+	if (line) {
+		d->hits += 1;
+		lru_unlink(d, line);
+		lru_push(d, line);
+	}
+	else {
+		d->misses += 1;
+		line = cache_take(d, address);
+	}
+
+	memcpy(line->data, sectordata, d->sectorsize);
+	line->dirty = true;
+}
+
+void chadfs64_read_sector(void* dev, uint64_t address, void* sectordata) {
+	ut_dev_t* d = (ut_dev_t*)dev;
+	if (!d->numlines) {
+		backend_read(d, address, sectordata);
+		return;
+	}
+
+	ut_cline_t* line = cache_find(d, address);
+	chadfs_stats_cache_access(line != NULL);
+	if (line) {
+		d->hits += 1;
+		lru_unlink(d, line);
+		lru_push(d, line);
+	}
+	else {
+		d->misses += 1;
+		line = cache_take(d, address);
+		backend_read(d, address, line->data);
+	}
+
+	memcpy(sectordata, line->data, d->sectorsize);
+}
+
+void chadfs32_write_sector(void* dev, uint32_t address, const void* sectordata) {
+	chadfs64_write_sector(dev, address, sectordata);
+}
+
+void chadfs32_read_sector(void* dev, uint32_t address, void* sectordata) {
+	chadfs64_read_sector(dev, address, sectordata);
+}
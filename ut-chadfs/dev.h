@@ -0,0 +1,47 @@
+#ifndef UT_DEV_H
+#define UT_DEV_H
+
+#include <stdio.h>
+#include <chadfs.h>
+
+/* Cached sector */
+typedef struct _ut_cline_t {
+	uint64_t				address;
+	bool					dirty;
+	struct _ut_cline_t*		prev;						/* LRU list (head - most recent) */
+	struct _ut_cline_t*		next;
+	struct _ut_cline_t*		hnext;						/* hash bucket chain */
+	uint8_t*				data;						/* ut_dev_t.linedata slot */
+} ut_cline_t;
+
+/* Device passed to the CHADFS library as `dev` */
+typedef struct _ut_dev_t {
+	FILE*			f;									/* image backend (NULL - RAM backend) */
+	uint8_t*		ram;								/* RAM backend data */
+	uint64_t		ramsectors;
+	uint32_t		sectorsize;							/* 512 or 4096 */
+
+	ut_cline_t*		lines;								/* write-back LRU cache (OPTIONAL) */
+	ut_cline_t**	buckets;
+	uint8_t*		linedata;
+	ut_cline_t*		head;
+	ut_cline_t*		tail;
+	uint32_t		numlines;
+	uint32_t		usedlines;
+	uint32_t		numbuckets;
+
+	uint64_t		breads;								/* backend sector reads */
+	uint64_t		bwrites;							/* backend sector writes */
+	uint64_t		hits;
+	uint64_t		misses;
+} ut_dev_t;
+
+void ut_dev_init_file(ut_dev_t* dev, FILE* f, uint32_t sectorsize, uint32_t cachesectors);
+void ut_dev_init_ram(ut_dev_t* dev, uint32_t sectorsize, uint32_t cachesectors);
+void ut_dev_set_sector_size(ut_dev_t* dev, uint32_t sectorsize);
+void ut_dev_flush(ut_dev_t* dev);
+void ut_dev_sync(void* dev);
+void ut_dev_discard(void* dev, uint64_t address, uint64_t count);
+void ut_dev_close(ut_dev_t* dev);
+
+#endif
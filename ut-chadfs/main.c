@@ -1,85 +1,193 @@
 #include <stdlib.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <string.h>
-#include <chadfs.h>
+#include <time.h>
+#include <dirent.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
-#define PANIC_ERR(__status) {\
-	fprintf(stderr, "Error: `%s`!\n", chadfs_status_to_str(__status));\
-	exit(-1);\
-	return;\
-}
+#include <murmur.h>
+#include <chadfs-scan.h>
+#include "ut.h"
 
 void act_show_info(void* ppath);
-void act_create_mblk(const char* mpath);
-void act_add_vblk(const char* mpath, const char* name, uint32_t numiblks);
-void act_list_vblks(const char* mpath);
-void act_print_volume(const char* mpath, const char* name);
-void act_print_file(const char* mpath, const char* fpath);
-void act_list_dir(const char* mpath, const char* dpath);
-void act_create_file(const char* mpath, const char* infpath, const char* extfpath);
-void act_create_dir(const char* mpath, const char* indirpath);
-void act_read_txt_file(const char* mpath, const char* infpath, uint32_t offset, uint32_t len);
-void act_read_bin_file(const char* mpath, const char* infpath, uint32_t offset, uint32_t len);
-void act_trunc_file(const char* mpath, const char* fpath, uint32_t len);
-void act_remove_file(const char* mpath, const char* fpath);
-void act_write_file(const char* mpath, const char* infpath, const char* extfpath, uint32_t offset);
+void act_create_mblk(const char* mpath, uint32_t version, uint32_t sectorsize);
+void act_batch(const char* mpath, const char* spath);
+void act_replay(const char* tpath, const char* mpath, int numcaches, char** caches);
+void act_bench_scan(uint32_t numentries, uint32_t passes);
+
+static chadfs_stats_t stats;
+static chadfs_tracer_t tracer;
+void print_stats(void);
+void open_trace(const char* tpath);
+void close_trace(void);
+void set_trace_sector_size(uint32_t sectorsize);
+
+static ut_img_t* curimg = NULL;
+const char* curimgpath = NULL;
+static uint32_t cachesectors = UT_DEFAULT_CACHE_SECTORS;
+static size_t delaybytes = 0;
+static uint32_t fileattrs = 0;
+static bool dedup = false;
+static uint8_t volflags = 0;
+static const char* jvolume = NULL;
+static chadfs_journal_t journal;
+static chadfs_discarder_t discarder = { ut_dev_discard };
+static void* jbuffer = NULL;
+void open_img(ut_img_t* img, const char* mpath);
+void close_img(void);
+bool run_action(ut_img_t* img, int argc, char** argv);
 
 int main(int argc, char** argv) {
-	if (argc >= 2 && (!strcmp(argv[1], "-help") || !strcmp(argv[1], "-info"))) act_show_info(argv[0]);
-	else if (argc >= 3 && !strcmp(argv[1], "-create-main")) act_create_mblk(argv[2]);
-	else if (argc >= 5 && !strcmp(argv[1], "-add-volume")) act_add_vblk(argv[2], argv[3], (uint32_t)strtoul(argv[4], NULL, 10));
-	else if (argc >= 3 && !strcmp(argv[1], "-list-volumes")) act_list_vblks(argv[2]);
-	else if (argc >= 4 && !strcmp(argv[1], "-list-dir")) act_list_dir(argv[2], argv[3]);
-	else if (argc >= 4 && !strcmp(argv[1], "-print-volume")) act_print_volume(argv[2], argv[3]);
-	else if (argc >= 4 && !strcmp(argv[1], "-print-file")) act_print_file(argv[2], argv[3]);
-	else if (argc >= 4 && !strcmp(argv[1], "-create-dir")) act_create_dir(argv[2], argv[3]);
-	else if (argc >= 4 && !strcmp(argv[1], "-create-file")) {
-		char* extfpath = NULL;
-		if (argc >= 5) extfpath = argv[4];
-		act_create_file(argv[2], argv[3], extfpath);
-	}
-	else if (argc >= 4 && !strcmp(argv[1], "-read-txt-file")) {
-		uint32_t offset = 0;
-		uint32_t len = 0;
-		if (argc >= 5) {
-			offset = (uint32_t)strtoul(argv[4], NULL, 10);
-			if (argc >= 6) len = (uint32_t)strtoul(argv[5], NULL, 10);
+	for (;;) {
+		if (argc >= 2 && !strcmp(argv[1], "-stats")) {
+			stats.clock = host_clock;
+			chadfs_set_stats(&stats);
+			atexit(print_stats);
+
+			argv[1] = argv[0];
+			argv += 1;
+			argc -= 1;
+		}
+		else if (argc >= 3 && !strcmp(argv[1], "-trace")) {
+			open_trace(argv[2]);
+
+			argv[2] = argv[0];
+			argv += 2;
+			argc -= 2;
+		}
+		else if (argc >= 3 && !strcmp(argv[1], "-journal")) {
+			jvolume = argv[2];
+
+			argv[2] = argv[0];
+			argv += 2;
+			argc -= 2;
+		}
+		else if (argc >= 3 && !strcmp(argv[1], "-delay")) {
+			delaybytes = (size_t)strtoull(argv[2], NULL, 0);
+
+			argv[2] = argv[0];
+			argv += 2;
+			argc -= 2;
+		}
+		else if (argc >= 2 && !strcmp(argv[1], "-defer-free")) {
+			chadfs_set_deferred_free(true);
+
+			argv[1] = argv[0];
+			argv += 1;
+			argc -= 1;
+		}
+		else if (argc >= 2 && !strcmp(argv[1], "-dedup")) {
+			dedup = true;
+
+			argv[1] = argv[0];
+			argv += 1;
+			argc -= 1;
+		}
+		else if (argc >= 2 && !strcmp(argv[1], "-wide-ids")) {
+			volflags |= CHADFS_VOLUME_WIDE_IDS;
+
+			argv[1] = argv[0];
+			argv += 1;
+			argc -= 1;
 		}
+		else if (argc >= 2 && !strcmp(argv[1], "-compress")) {
+			fileattrs |= CHADFS_FILE_ATTRIBUTE_COMPRESSED;
 
-		act_read_txt_file(argv[2], argv[3], offset, len);
+			argv[1] = argv[0];
+			argv += 1;
+			argc -= 1;
+		}
+		else if (argc >= 3 && !strcmp(argv[1], "-scan-isa")) {
+			chadfs_scan_isa_t isa = CHADFS_SCAN_AUTO;
+			while (isa <= CHADFS_SCAN_AVX2 && strcmp(argv[2], chadfs_scan_isa_str(isa))) ++isa;
+			if (isa > CHADFS_SCAN_AVX2) {
+				fprintf(stderr, "Unknown scan kernels `%s`!\n", argv[2]);
+				exit(-1);
+			}
+
+			if (chadfs_set_scan_isa(isa) != isa && isa != CHADFS_SCAN_AUTO) {
+				fprintf(stderr, "No %s on this CPU, using %s\n", argv[2], chadfs_scan_isa_str(chadfs_get_scan_isa()));
+			}
+
+			argv[2] = argv[0];
+			argv += 2;
+			argc -= 2;
+		}
+		else if (argc >= 3 && !strcmp(argv[1], "-cache")) {
+			cachesectors = (uint32_t)strtoul(argv[2], NULL, 10);
+
+			argv[2] = argv[0];
+			argv += 2;
+			argc -= 2;
+		}
+		else break;
 	}
-	else if (argc >= 4 && !strcmp(argv[1], "-read-bin-file")) {
-		uint32_t offset = 0;
-		uint32_t len = 0;
-		if (argc >= 5) {
-			offset = (uint32_t)strtoul(argv[4], NULL, 10);
-			if (argc >= 6) len = (uint32_t)strtoul(argv[5], NULL, 10);
+
+	if (argc >= 2 && (!strcmp(argv[1], "-help") || !strcmp(argv[1], "-info"))) act_show_info(argv[0]);
+	else if (argc >= 3 && !strcmp(argv[1], "-create-main")) act_create_mblk(
+		argv[2],
+		argc >= 4 ? (uint32_t)strtoul(argv[3], NULL, 0) : CHADFS_VERSION32,
+		argc >= 5 ? (uint32_t)strtoul(argv[4], NULL, 0) : CHADFS_MIN_SECTOR_SIZE
+	);
+	else if (argc >= 4 && !strcmp(argv[1], "-replay")) act_replay(argv[2], argv[3], argc - 4, &argv[4]);
+	else if (argc >= 3 && !strcmp(argv[1], "-batch")) act_batch(argv[2], argc >= 4 ? argv[3] : "-");
+	else if (argc >= 2 && !strcmp(argv[1], "-bench-scan")) act_bench_scan(
+		argc >= 3 ? (uint32_t)strtoul(argv[2], NULL, 0) : 0,
+		argc >= 4 ? (uint32_t)strtoul(argv[3], NULL, 10) : 0
+	);
+	else if (argc >= 3) {
+		ut_img_t img;
+		open_img(&img, argv[2]);
+		if (!run_action(&img, argc, argv)) {
+			close_img();
+			fprintf(stderr, "Unknown action or/and invalid params! (`-help` - show info)\n");
+			return -1;
 		}
 
-		act_read_bin_file(argv[2], argv[3], offset, len);
+		close_img();
 	}
-	else if (
-		argc >= 5 && !strcmp(argv[1], "-trunc-file")
-	) act_trunc_file(argv[2], argv[3], (uint32_t)strtoul(argv[4], NULL, 10));
-	else if (argc >= 4 && !strcmp(argv[1], "-remove-file")) act_remove_file(argv[2], argv[3]);
-	else if (
-		argc >= 6 && !strcmp(argv[1], "-write-file")
-	) act_write_file(argv[2], argv[3], argv[4], (uint32_t)strtoul(argv[5], NULL, 10));
 	else {
 		fprintf(stderr, "Unknown action or/and invalid params! (`-help` - show info)\n");
 		return -1;
 	}
 }
 
+/*
+	Run image action, argv[1] - action, argv[2] - image path (already opened)
+*/
+bool run_action(ut_img_t* img, int argc, char** argv) {
+	if (img->version == CHADFS_VERSION64) return ut64_run_action(img, argc, argv);
+	return ut32_run_action(img, argc, argv);
+}
+
 void act_show_info(void* ppath) {
 	printf("CHADFS utility (v1). Usage: `%s <action> [params]`\nActions:\n", (char*)ppath);
 
 	puts("`-help`/`-info` - show info(actions & params...)");
-	puts("`-create-main <path>` - create CHADFS binary image");
-
-	puts("`-add-volume <path> <name> <numiblks>` - add volume");
+	puts("`-stats <action> [params]` - run action and print I/O stats (to stderr)");
+	puts("`-trace <tpath> <action> [params]` - run action and record sector accesses");
+	puts("\t<tpath> - trace file path");
+	puts("`-cache <sectors> <action> [params]` - set write-back sector cache size (default - 8192)");
+	puts("`-journal <name> <action> [params]` - log metadata writes in the journal of volume <name>");
+	puts("`-delay <bytes> <action> [params]` - buffer file writes, allocate space per <bytes> (delayed allocation)");
+	puts("`-defer-free <action> [params]` - queue data freed by remove/truncate, free it with `-reclaim`");
+	puts("`-compress <action> [params]` - store data of created files in LZ4 compressed chunks of 16 KiB (clusters up to 16 KiB)");
+	puts("`-dedup <action> [params]` - files of `-import-tree` equal to one imported before and `-copy-file` copies share data (copied on the first change)");
+	puts("`-wide-ids <action> [params]` - added volumes keep a second 32-bit hash per file id (lookups compare 63 bits)");
+	puts("`-scan-isa <isa> <action> [params]` - scan id tables with `scalar`, `sse2` or `avx2` kernels (default - `auto`, the best one the CPU has)");
+	puts("`-create-main <path> [width] [sectorsize]` - create CHADFS binary image");
+	puts("\t[width] - 32 (default) or 64 (CHADFS(64), 64-bit sizes and addresses)");
+	puts("\t[sectorsize] - 512 (default) or 4096 (the other actions detect it)");
+
+	puts("`-add-volume <path> <name> <numiblks> [clustersize] [jsectors]` - add volume");
 	puts("\t<name> - volume name");
 	puts("\t<numiblks> - num of ID blocks");
+	puts("\t[clustersize] - allocation unit in bytes, power of two sectors up to 1 MiB (default - one sector)");
+	puts("\t[jsectors] - journal size in sectors, 0 (default) - no journal");
 
 	puts("`-list-volumes <path>` - list volumes");
 	puts("`-list-dir <path> <dpath>` - list files in directory");
@@ -90,16 +198,59 @@ void act_show_info(void* ppath) {
 	puts("`-print-file <path> <fpath>` - show file (info)");
 	puts("\t<fpath> - file path (inside CHADFS binary img)");
 
-	puts("`-copy-file <path> <infpath> [extfpath]` - create file");
+	puts("`-create-file <path> <infpath> [extfpath]` - create file");
+	puts("`-copy-file <path> <srcfpath> <dstfpath>` - copy file inside image (to any volume), with `-dedup` share its data in the same volume");
+	puts("`-rename-file <path> <oldfpath> <newfpath>` - rename or move file or directory inside its volume (data is not copied)");
 	puts("`-create-dir <path> <indpath>` - create directory");
 	puts("`-read-txt-file <path> <fpath> [offset] [size]` - read text file");
 	puts("`-read-bin-file <path> <fpath> [offset] [size]` - read binary file");
-	puts("`-trunc-file <path> <fpath> <size>` - truncate file");
+	puts("`-trunc-file <path> <fpath> <size>` - truncate file (a larger <size> appends a hole)");
+	puts("`-prealloc-file <path> <fpath> <size>` - reserve adjacent space for file to grow to <size> (bytes)");
+	puts("`-punch-hole <path> <fpath> <offset> <size>` - make file range read as zeros, whole clusters free their space (not compressed files)");
 	puts("`-remove-file <path> <fpath>` - remove file");
-	puts("`-write-file <path> <infpath> <extfpath> <offset>` - copy external file content to internal file");
+	puts("`-remove-tree <path> <fpath>` - remove directory with everything in it (or file)");
+	puts("`-write-file <path> <infpath> <extfpath> <offset>` - copy external file content to internal file (past the end leaves a hole)");
+	puts("`-defrag <path> <name> [budget] [statepath]` - move fragmented file data of volume into adjacent cells");
+	puts("\t[budget] - sectors per step (file blocks looked at and data moved), 0 (default) - no limit");
+	puts("\t[statepath] - run one step, keep the pass position in this file until the pass is done");
+	puts("`-reclaim <path> <name> [budget]` - free data queued by `-defer-free` in volume <name>");
+	puts("\t[budget] - max num of cells to free, 0 (default) - all");
+	puts("`-bench-read <path> <fpath> [passes] [size]` - time sequential, then as many random reads of file");
+	puts("\t[passes] - times the file is read (default - 1)");
+	puts("\t[size] - bytes per read (default - 4096), throughput counts file bytes (use `-cache 0` for device reads)");
+	puts("`-bench-scan [entries] [passes]` - time id table scans of every kernel set the CPU has (no image)");
+	puts("\t[entries] - id table size (default - 16384), scanned one id block at a time per width and sector size");
+	puts("\t[passes] - times the table is scanned (default - 1024)");
+	puts("`-import-tree <path> <hdpath> <indpath>` - copy host directory tree into existing directory");
+	puts("\t<hdpath> - host directory path");
+	puts("\t<indpath> - directory path (inside CHADFS binary img), e.g. volume name");
+	puts("`-export-tree <path> <indpath> <hdpath> [threads]` - copy directory tree to host");
+	puts("\t<hdpath> - host directory path (created if missing)");
+	puts("\t[threads] - num of reading threads (default - num of CPUs)");
+	puts("`-batch <path> [spath]` - run actions from script against one opened image");
+	puts("\t[spath] - script path (default - `-`, stdin), one action per line without <path>");
+	puts("\t\t(e.g. `-create-file vol/a ./a.txt`), `#` - comment");
+	puts("`-replay <tpath> <path> [cachesectors...]` - re-execute trace (once per cache size)");
+	puts("\t<path> - image (written sectors get clobbered, use a copy) or `-ram`");
+	puts("\t[cachesectors...] - write-back cache sizes in sectors (default - 0)");
 }
 
-void act_create_mblk(const char* mpath) {
+void act_create_mblk(const char* mpath, uint32_t version, uint32_t sectorsize) {
+	if (version != CHADFS_VERSION32 && version != CHADFS_VERSION64) {
+		fprintf(stderr, "Unknown CHADFS width `%u`!\n", (unsigned)version);
+		exit(-1);
+		return;
+	}
+
+	union {
+		chadfs32_mblk_t	m32;
+		chadfs64_mblk_t	m64;
+	} mblk;
+	chadfs_status_t status;
+	if (version == CHADFS_VERSION64) status = chadfs64_init_mblk(&mblk.m64, sectorsize);
+	else status = chadfs32_init_mblk(&mblk.m32, sectorsize);
+	if (status != CHADFS_STATUS_OK) PANIC_ERR(status);
+
 	FILE* f = fopen(mpath, "wb");
 	if (!f) {
 		fprintf(stderr, "Failed to create file `%s`!\n", mpath);
@@ -107,9 +258,9 @@ void act_create_mblk(const char* mpath) {
 		return;
 	}
 
-	chadfs32_mblk_t mblk;
-	chadfs32_init_mblk(&mblk);
-	if (fwrite(&mblk, sizeof(mblk), 1, f) != 1) {
+	/* the image starts with one whole sector */
+	sectorsize = CHADFS_SECTOR_SIZE_OF(version == CHADFS_VERSION64 ? mblk.m64.sectorshift : mblk.m32.sectorshift);
+	if (fwrite(&mblk, sectorsize, 1, f) != 1) {
 		fprintf(stderr, "Failed to write data to file `%s`!\n", mpath);
 		exit(-1);
 		return;
@@ -118,347 +269,496 @@ void act_create_mblk(const char* mpath) {
 	fclose(f);
 }
 
-void act_add_vblk(const char* mpath, const char* name, uint32_t numiblks) {
-	chadfs_status_t status;
-	chadfs32_vblk_t vblk;
-	chadfs_sv_t sv = { (char*)name, strlen(name) };
-	chadfs32_init_vblk(&vblk, &sv, numiblks);
+static void set_scan_entry(uint64_t* blk, uint32_t width, uint32_t i, uint64_t first, uint64_t second) {
+	if (width == 64) {
+		blk[2 * i] = first;
+		blk[2 * i + 1] = second;
+	}
+	else {
+		((uint32_t*)blk)[2 * i] = (uint32_t)first;
+		((uint32_t*)blk)[2 * i + 1] = (uint32_t)second;
+	}
+}
 
-	FILE* f = fopen(mpath, "rb+");
-	if (!f) {
-		fprintf(stderr, "Failed to open file `%s`!\n", mpath);
+/*
+	Put a free entry at every index of a block (so across 16 and 32-byte
+	lanes and into the scalar tail), with entries free in one word only
+	next to it, and check every kernel set up to `best` finds exactly it
+*/
+static void check_scan_kernels(const uint64_t* table, uint32_t width, uint32_t numblk, chadfs_scan_isa_t best) {
+	uint64_t* blk = (uint64_t*)malloc((size_t)numblk * 2 * sizeof(uint64_t));
+	if (!blk) {
+		fprintf(stderr, "Not enough memory!\n");
 		exit(-1);
-		return;
 	}
 
-	chadfs32_mblk_t mblk;
-	status = chadfs32_read_mblk(f, 0, &mblk);
-	if (status != CHADFS_STATUS_OK) PANIC_ERR(status);
-
-	chadfs32_loc_t mblkloc = { 0, &mblk };
-	status = chadfs32_add_volume(f, &mblkloc, &vblk);
-	if (status != CHADFS_STATUS_OK) PANIC_ERR(status);
+	const uint32_t counts[] = { numblk, numblk - 1, numblk - 5 };
+	const uint32_t froms[] = { 0, 1, 7, 9 };
+	for (uint32_t ifree = 0; ifree < numblk; ++ifree) {
+		/* first word free before it, second word free after it */
+		const uint32_t ifirst = (ifree + numblk - 1) % numblk;
+		const uint32_t isecond = (ifree + 1) % numblk;
+		memcpy(blk, table, (size_t)numblk * 2 * sizeof(uint64_t));
+		set_scan_entry(blk, width, ifirst, 0, 1);
+		set_scan_entry(blk, width, isecond, 1, 0);
+		set_scan_entry(blk, width, ifree, 0, 0);
+
+		for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c) {
+			const uint32_t count = counts[c];
+			uint32_t rexpected = CHADFS_SCAN_NONE;
+			if (ifree < count) rexpected = ifree;
+			if (ifirst < count && (rexpected == CHADFS_SCAN_NONE || ifirst > rexpected)) rexpected = ifirst;
+
+			for (chadfs_scan_isa_t isa = CHADFS_SCAN_SCALAR; isa <= best; ++isa) {
+				chadfs_set_scan_isa(isa);
+				const uint32_t rfound = width == 64 ? chadfs64_rscan_zero(blk, count) : chadfs32_rscan_zero(blk, count);
+				if (rfound != rexpected) {
+					fprintf(
+						stderr, "Scan kernels `%s` CHADFS(%u) rscan of %u entries: %u, not %u!\n",
+						chadfs_scan_isa_str(isa), (unsigned)width, (unsigned)count, (unsigned)rfound, (unsigned)rexpected
+					);
+					exit(-1);
+				}
+
+				for (size_t f = 0; f < sizeof(froms) / sizeof(froms[0]); ++f) {
+					const uint32_t ifrom = froms[f];
+					const uint32_t expected = ifrom <= ifree && ifree < count ? ifree : count;
+					const uint32_t found = width == 64
+						? chadfs64_scan_pairs(blk, ifrom, count, 0, 0)
+						: chadfs32_scan_pairs(blk, ifrom, count, 0, 0);
+					if (found != expected) {
+						fprintf(
+							stderr, "Scan kernels `%s` CHADFS(%u) scan of [%u, %u): %u, not %u!\n",
+							chadfs_scan_isa_str(isa), (unsigned)width, (unsigned)ifrom, (unsigned)count,
+							(unsigned)found, (unsigned)expected
+						);
+						exit(-1);
+					}
+				}
+			}
+		}
+	}
 
-	fclose(f);
+	free(blk);
 }
 
-void act_list_vblks(const char* mpath) {
-	chadfs_status_t status;
-	FILE* f = fopen(mpath, "rb+");
-	if (!f) {
-		fprintf(stderr, "Failed to open file `%s`!\n", mpath);
+/*
+	Check every kernel set the CPU has on known free entries, then time
+	scans of a full id table with each: a file id that is not there (as
+	for a free file cell) and free data cells when there are none, so
+	each entry is looked at
+*/
+void act_bench_scan(uint32_t numentries, uint32_t passes) {
+	if (!numentries) numentries = UT_BENCH_SCAN_ENTRIES;
+	if (!passes) passes = UT_BENCH_SCAN_PASSES;
+
+	/* CHADFS(64) entries are two uint64_t, CHADFS(32) ones use the first half */
+	uint64_t* table = (uint64_t*)malloc((size_t)numentries * 2 * sizeof(uint64_t));
+	if (!table) {
+		fprintf(stderr, "Not enough memory!\n");
 		exit(-1);
-		return;
 	}
 
-	chadfs32_mblk_t mblk;
-	status = chadfs32_read_mblk(f, 0, &mblk);
-	if (status != CHADFS_STATUS_OK) PANIC_ERR(status);
-
-	uint32_t saddr = mblk.firstvolume;
-	chadfs32_vblk_t tmpvblk;
-	for (size_t i = 0; i < mblk.numvolumes; ++i) {
-		chadfs32_read_sector(f, saddr, &tmpvblk);
-		printf("%u) `%s`(lba=0x%x):\n", (unsigned)(i + 1), (char*)tmpvblk.name, (unsigned)saddr);
-		printf("Num of ID blocks: %u\n", (unsigned)tmpvblk.numiblks);
-		printf("Num of file blocks: %u\n", (unsigned)tmpvblk.numfblks);
-		printf("Num of data blocks: %u\n", (unsigned)tmpvblk.numdblks);
-		printf("Next volume: 0x%x/%u\n\n", (unsigned)tmpvblk.nextvolume, (unsigned)tmpvblk.nextvolume);
-
-		saddr += tmpvblk.nextvolume;
+	/* no word is 0 */
+	uint64_t seed = 0x9E3779B97F4A7C15U;
+	for (size_t i = 0; i < (size_t)numentries * 2; ++i) {
+		seed ^= seed << 13;
+		seed ^= seed >> 7;
+		seed ^= seed << 17;
+		table[i] = seed | 0x100000001U;
+	}
+
+	const chadfs_scan_isa_t best = chadfs_set_scan_isa(CHADFS_SCAN_AUTO);
+	for (uint32_t width = 32; width <= 64; width += 32) {
+		for (uint32_t sectorsize = CHADFS_MIN_SECTOR_SIZE; sectorsize <= CHADFS_MAX_SECTOR_SIZE; sectorsize <<= 3) {
+			const uint32_t numblk = sectorsize / (width / 4);
+			const uint32_t numblks = numentries / numblk;
+			const double numscanned = (double)passes * numblks * numblk;
+			check_scan_kernels(table, width, numblk, best);
+
+			double scalarns[2] = { 0, 0 };
+			for (chadfs_scan_isa_t isa = CHADFS_SCAN_SCALAR; isa <= best; ++isa) {
+				chadfs_set_scan_isa(isa);
+				double ns[2];
+				for (int kind = 0; kind < 2; ++kind) {
+					bool found = false;
+					const uint64_t start = host_clock();
+					for (uint32_t pass = 0; pass < passes; ++pass) {
+						for (uint32_t i = 0; i < numblks; ++i) {
+							if (width == 64) {
+								const uint64_t* blk = &table[(size_t)i * numblk * 2];
+								if (kind) found |= chadfs64_rscan_zero(blk, numblk) != CHADFS_SCAN_NONE;
+								else found |= chadfs64_scan_pairs(blk, 0, numblk, 0, 0) != numblk;
+							}
+							else {
+								const uint32_t* blk = &((const uint32_t*)table)[(size_t)i * numblk * 2];
+								if (kind) found |= chadfs32_rscan_zero(blk, numblk) != CHADFS_SCAN_NONE;
+								else found |= chadfs32_scan_pairs(blk, 0, numblk, 0, 0) != numblk;
+							}
+						}
+					}
+
+					ns[kind] = (double)(host_clock() - start) / numscanned;
+					if (found) {
+						fprintf(stderr, "Scan kernels `%s` found an entry that is not there!\n", chadfs_scan_isa_str(isa));
+						exit(-1);
+					}
+				}
+
+				if (isa == CHADFS_SCAN_SCALAR) {
+					scalarns[0] = ns[0];
+					scalarns[1] = ns[1];
+				}
+
+				printf(
+					"CHADFS(%u) %4u: %-6s  ids %.3f ns/entry (x%.1f), free data %.3f ns/entry (x%.1f)\n",
+					(unsigned)width, (unsigned)sectorsize, chadfs_scan_isa_str(isa),
+					ns[0], ns[0] > 0 ? scalarns[0] / ns[0] : 0.0, ns[1], ns[1] > 0 ? scalarns[1] / ns[1] : 0.0
+				);
+			}
+		}
 	}
 
-	fclose(f);
+	chadfs_set_scan_isa(CHADFS_SCAN_AUTO);
+	free(table);
 }
 
-void act_print_volume(const char* mpath, const char* name) {
-	chadfs_status_t status;
-	FILE* f = fopen(mpath, "rb+");
-	if (!f) {
-		fprintf(stderr, "Failed to open file `%s`!\n", mpath);
+uint8_t* alloc_chunk(void) {
+	uint8_t* chunk = (uint8_t*)malloc(UT_IMPORT_CHUNK);
+	if (!chunk) {
+		fprintf(stderr, "Not enough memory!\n");
 		exit(-1);
-		return;
 	}
 
-	chadfs32_mblk_t mblk;
-	status = chadfs32_read_mblk(f, 0, &mblk);
-	if (status != CHADFS_STATUS_OK) PANIC_ERR(status);
+	return chunk;
+}
 
-	chadfs32_loc_t mblkloc = { 0, &mblk };
-	chadfs_sv_t sv = { (char*)name, strlen(name) };
-	chadfs32_vblk_t tmpvblk;
-	chadfs32_eloc_t tmpvblkeloc;
-	status = chadfs32_read_vblk(f, &mblkloc, &sv, &tmpvblk, &tmpvblkeloc);
-	if (status != CHADFS_STATUS_OK) PANIC_ERR(status);
+char* join_path(const char* a, const char* b) {
+	size_t al = strlen(a);
+	size_t bl = strlen(b);
+	char* res = (char*)malloc(al + bl + 2);
+	if (!res) {
+		fprintf(stderr, "Not enough memory!\n");
+		exit(-1);
+	}
 
-	printf("`%s` (lba=0x%x, index=%u):\n", (char*)tmpvblk.name, (unsigned)tmpvblkeloc.a, (unsigned)tmpvblkeloc.i);
-	printf("Num of ID blocks: %u\n", (unsigned)tmpvblk.numiblks);
-	printf("Num of file blocks: %u\n", (unsigned)tmpvblk.numfblks);
-	printf("Num of data blocks: %u\n", (unsigned)tmpvblk.numdblks);
-	printf("Next volume: 0x%x/%u\n\n", (unsigned)tmpvblk.nextvolume, (unsigned)tmpvblk.nextvolume);
+	memcpy(res, a, al);
+	res[al] = '/';
+	memcpy(&res[al + 1], b, bl + 1);
+	return res;
+}
 
-	fclose(f);
+static int cmp_tentries(const void* a, const void* b) {
+	return strcmp(((const ut_tentry_t*)a)->ipath, ((const ut_tentry_t*)b)->ipath);
 }
 
-void act_print_file(const char* mpath, const char* fpath) {
-	chadfs_status_t status;
-	FILE* f = fopen(mpath, "rb+");
-	if (!f) {
-		fprintf(stderr, "Failed to open file `%s`!\n", mpath);
+/*
+	Walk host tree (breadth-first, so entries of one directory are adjacent)
+*/
+ut_tentry_t* plan_tree(const char* hdirpath, const char* indirpath, uint64_t maxsize, size_t* numentries) {
+	size_t cap = 64;
+	size_t num = 1;
+	ut_tentry_t* entries = (ut_tentry_t*)malloc(cap * sizeof(ut_tentry_t));
+	if (!entries) {
+		fprintf(stderr, "Not enough memory!\n");
 		exit(-1);
-		return;
 	}
 
-	chadfs32_mblk_t mblk;
-	status = chadfs32_read_mblk(f, 0, &mblk);
-	if (status != CHADFS_STATUS_OK) PANIC_ERR(status);
+	entries[0].hpath = strdup(hdirpath);
+	entries[0].ipath = (char*)indirpath;
+	entries[0].dir = true;
+	entries[0].size = 0;
+	for (size_t i = 0; i < num; ++i) {
+		if (!entries[i].dir) continue;
 
-	chadfs32_eloc_t tmpfblkeloc;
-	chadfs32_fblk_t tmpfblk;
-	chadfs32_loc_t mblkloc = { 0, &mblk };
-	chadfs_sv_t svpath = { (char*)fpath, strlen(fpath) };
-	status = chadfs32_read_fblk(f, &mblkloc, &svpath, &tmpfblk, &tmpfblkeloc, NULL, NULL);
-	if (status != CHADFS_STATUS_OK) PANIC_ERR(status);
+		DIR* d = opendir(entries[i].hpath);
+		if (!d) {
+			fprintf(stderr, "Failed to open directory `%s`!\n", entries[i].hpath);
+			exit(-1);
+		}
 
-	printf("`%s` (lba=0x%x, index=%u):\n", fpath, (unsigned)tmpfblkeloc.a, (unsigned)tmpfblkeloc.i);
-	printf("Size: %u (bytes)\n", (unsigned)tmpfblk.size);
-	printf("First data block index: %u\n", (unsigned)tmpfblk.firstdblk);
-	printf("Last data block index: %u\n", (unsigned)tmpfblk.lastdblk);
-	printf("Attributes: 0x%x\n", (unsigned)tmpfblk.attributes);
-
-	if (tmpfblk.attributes & CHADFS_FILE_ATTRIBUTE_DIRECTORY) {
-		chadfs32_dirit_t iter;
-		status = chadfs32_create_iter(f, &mblkloc, &svpath, &iter, &tmpfblk);
-		if (status != CHADFS_STATUS_OK) {
-			if (status == CHADFS_STATUS_ZERO_DATA_LEN) puts("No files");
-			else PANIC_ERR(status);
+		size_t first = num;
+		struct dirent* de;
+		while ((de = readdir(d))) {
+			if (!strcmp(de->d_name, ".") || !strcmp(de->d_name, "..")) continue;
+
+			struct stat st;
+			char* hpath = join_path(entries[i].hpath, de->d_name);
+			if (stat(hpath, &st)) {
+				fprintf(stderr, "Failed to stat `%s`!\n", hpath);
+				exit(-1);
+			}
+
+			if (!S_ISDIR(st.st_mode) && !S_ISREG(st.st_mode)) {
+				free(hpath);
+				continue;
+			}
+
+			if (strlen(de->d_name) > CHADFS_MAX_FILE_NAME) {
+				fprintf(stderr, "Too long file name `%s`!\n", hpath);
+				exit(-1);
+			}
+
+			if (!S_ISDIR(st.st_mode) && (uint64_t)st.st_size > maxsize) {
+				fprintf(stderr, "Too big file `%s`!\n", hpath);
+				exit(-1);
+			}
+
+			if (num == cap) {
+				cap *= 2;
+				entries = (ut_tentry_t*)realloc(entries, cap * sizeof(ut_tentry_t));
+				if (!entries) {
+					fprintf(stderr, "Not enough memory!\n");
+					exit(-1);
+				}
+			}
+
+			entries[num].hpath = hpath;
+			entries[num].ipath = join_path(entries[i].ipath, de->d_name);
+			entries[num].dir = S_ISDIR(st.st_mode);
+			entries[num].size = entries[num].dir ? 0 : (uint64_t)st.st_size;
+			num += 1;
 		}
 
-		puts("Files:");
-		do {
-			printf("`%s/%s`:\n", fpath, (char*)tmpfblk.name);
-			printf("Size: %u (bytes)\n", (unsigned)tmpfblk.size);
-			printf("First data block index: %u\n", (unsigned)tmpfblk.firstdblk);
-			printf("Last data block index: %u\n", (unsigned)tmpfblk.lastdblk);
-			printf("Attributes: 0x%x\n\n", (unsigned)tmpfblk.attributes);
-			status = chadfs32_move_iter(f, &iter, &tmpfblk);
-			if (status != CHADFS_STATUS_OK && status != CHADFS_STATUS_ZERO_DATA_LEN) PANIC_ERR(status);
-		} while (status != CHADFS_STATUS_ZERO_DATA_LEN);
+		closedir(d);
+		entries[i].size = (uint32_t)(num - first);
+		qsort(&entries[first], num - first, sizeof(ut_tentry_t), cmp_tentries);
 	}
 
-	fclose(f);
+	*numentries = num;
+	return entries;
 }
 
-void act_list_dir(const char* mpath, const char* dpath) {
-	chadfs_status_t status;
-	FILE* f = fopen(mpath, "rb+");
-	if (!f) {
-		fprintf(stderr, "Failed to open file `%s`!\n", mpath);
+void make_host_dir(const char* hpath) {
+	if (mkdir(hpath, 0777) && errno != EEXIST) {
+		fprintf(stderr, "Failed to create directory `%s`!\n", hpath);
 		exit(-1);
-		return;
 	}
+}
 
-	chadfs32_mblk_t mblk;
-	status = chadfs32_read_mblk(f, 0, &mblk);
-	if (status != CHADFS_STATUS_OK) PANIC_ERR(status);
-
-	chadfs32_eloc_t tmpfblkeloc;
-	chadfs32_fblk_t tmpfblk;
-	chadfs32_loc_t mblkloc = { 0, &mblk };
-	chadfs_sv_t svpath = { (char*)dpath, strlen(dpath) };
-	status = chadfs32_read_fblk(f, &mblkloc, &svpath, &tmpfblk, &tmpfblkeloc, NULL, NULL);
-	if (status != CHADFS_STATUS_OK) PANIC_ERR(status);
-
-	if (!(tmpfblk.attributes & CHADFS_FILE_ATTRIBUTE_DIRECTORY)) PANIC_ERR(CHADFS_STATUS_NOT_DIR);
-
-	printf("Files in `%s`:\n", dpath);
-	chadfs32_dirit_t iter;
-	status = chadfs32_create_iter(f, &mblkloc, &svpath, &iter, &tmpfblk);
-	if (status != CHADFS_STATUS_OK) {
-		if (status == CHADFS_STATUS_ZERO_DATA_LEN) puts("No files");
-		else PANIC_ERR(status);
+static FILE* open_host_file(const char* hpath) {
+	FILE* f = fopen(hpath, "rb");
+	if (!f) {
+		fprintf(stderr, "Failed to open file `%s`!\n", hpath);
+		exit(-1);
 	}
 
-	do {
-		printf("`%s/%s`\n", dpath, (char*)tmpfblk.name);
-		status = chadfs32_move_iter(f, &iter, &tmpfblk);
-		if (status != CHADFS_STATUS_OK && status != CHADFS_STATUS_ZERO_DATA_LEN) PANIC_ERR(status);
-	} while (status != CHADFS_STATUS_ZERO_DATA_LEN);
+	return f;
+}
+
+/*
+	Content fingerprint of a host file: Murmur3Dword of every
+	UT_IMPORT_CHUNK bytes, seeded with the hash of the ones before
+*/
+uint32_t hash_host_file(const char* hpath, uint8_t* chunk) {
+	FILE* f = open_host_file(hpath);
+	uint32_t hash = 0;
+	size_t len;
+	while ((len = fread(chunk, 1, UT_IMPORT_CHUNK, f))) hash = Murmur3Dword(chunk, len, hash);
 
 	fclose(f);
+	return hash;
 }
 
-void act_create_file(const char* mpath, const char* infpath, const char* extfpath) {
-	chadfs_status_t status;
-	FILE* f = fopen(mpath, "rb+");
-	if (!f) {
-		fprintf(stderr, "Failed to open file `%s`!\n", mpath);
-		exit(-1);
-		return;
-	}
-
-	chadfs32_mblk_t mblk;
-	chadfs32_loc_t mblkloc = { 0, (void*)&mblk };
-	status = chadfs32_read_mblk(f, 0, &mblk);
-	if (status != CHADFS_STATUS_OK) PANIC_ERR(status);
+/*
+	Compare two host files byte by byte (equal fingerprints may collide)
+*/
+bool same_host_files(const char* apath, const char* bpath, uint8_t* chunk) {
+	FILE* af = open_host_file(apath);
+	FILE* bf = open_host_file(bpath);
+	uint8_t* other = alloc_chunk();
+	bool same = true;
+	for (;;) {
+		const size_t alen = fread(chunk, 1, UT_IMPORT_CHUNK, af);
+		const size_t blen = fread(other, 1, UT_IMPORT_CHUNK, bf);
+		if (alen != blen || memcmp(chunk, other, alen)) same = false;
+		if (!same || !alen) break;
+	}
+
+	free(other);
+	fclose(bf);
+	fclose(af);
+	return same;
+}
 
-	chadfs_sv_t svinfpath = { (char*)infpath, strlen(infpath) };
-	if (extfpath) {
-		FILE* extf = fopen(extfpath, "rb");
-		if (!extf) {
-			fprintf(stderr, "Failed to open file `%s`!\n", extfpath);
+/*
+	Run actions from script (`-` - stdin) against one opened image
+*/
+void act_batch(const char* mpath, const char* spath) {
+	FILE* sf = stdin;
+	if (strcmp(spath, "-")) {
+		sf = fopen(spath, "r");
+		if (!sf) {
+			fprintf(stderr, "Failed to open file `%s`!\n", spath);
 			exit(-1);
 			return;
 		}
+	}
 
-		fseek(extf, 0, SEEK_END);
-		size_t extflen = (size_t)ftell(extf);
-		fseek(extf, 0, SEEK_SET);
-
-		uint8_t* extfdata = (uint8_t*)malloc(extflen);
-		if (!extfdata) {
-			fprintf(stderr, "Not enough memory!\n");
-			exit(-1);
-			return;
+	ut_img_t img;
+	open_img(&img, mpath);
+
+	char line[4096];
+	char* argv[UT_MAX_BATCH_ARGS + 2];
+	argv[0] = "batch";
+	argv[2] = (char*)mpath;
+	for (size_t iline = 1; fgets(line, sizeof(line), sf); ++iline) {
+		/* split by whitespaces ("..." - one param), argv[2] stays the image path */
+		int numtokens = 0;
+		char* c = line;
+		for (;;) {
+			while (*c == ' ' || *c == '\t' || *c == '\r' || *c == '\n') ++c;
+			if (!*c || *c == '#') break;
+			if (numtokens == UT_MAX_BATCH_ARGS) {
+				fprintf(stderr, "%s:%u: Too many params!\n", spath, (unsigned)iline);
+				exit(-1);
+				return;
+			}
+
+			char quote = 0;
+			if (*c == '"') quote = *c++;
+			argv[numtokens ? numtokens + 2 : 1] = c;
+			numtokens += 1;
+
+			while (*c && (quote ? *c != quote : (*c != ' ' && *c != '\t' && *c != '\r' && *c != '\n'))) ++c;
+			if (*c) *c++ = 0;
 		}
 
-		if (fread(extfdata, extflen, 1, extf) != 1) {
-			fprintf(stderr, "Failed to read file `%s`!\n", extfpath);
+		if (!numtokens) continue;
+		if (!run_action(&img, numtokens + 2, argv)) {
+			fprintf(stderr, "%s:%u: Unknown action or/and invalid params!\n", spath, (unsigned)iline);
 			exit(-1);
 			return;
 		}
-
-		fclose(extf);
-
-		status = chadfs32_create_file(
-			f, &mblkloc, &svinfpath,
-			CHADFS_FILE_ATTRIBUTE_READABLE | CHADFS_FILE_ATTRIBUTE_WRITEABLE,
-			extfdata, (uint32_t)extflen
-		);
-
-		free(extfdata);
 	}
-	else status = chadfs32_create_file(
-		f, &mblkloc, &svinfpath,
-		CHADFS_FILE_ATTRIBUTE_READABLE | CHADFS_FILE_ATTRIBUTE_WRITEABLE,
-		NULL, 0
-	);
 
-	if (status != CHADFS_STATUS_OK) PANIC_ERR(status);
-	fclose(f);
+	if (sf != stdin) fclose(sf);
+	close_img();
 }
 
-void act_create_dir(const char* mpath, const char* indirpath) {
-	chadfs_status_t status;
-	FILE* f = fopen(mpath, "rb+");
-	if (!f) {
-		fprintf(stderr, "Failed to open file `%s`!\n", mpath);
+void act_replay(const char* tpath, const char* mpath, int numcaches, char** caches) {
+	FILE* tf = fopen(tpath, "rb");
+	if (!tf) {
+		fprintf(stderr, "Failed to open file `%s`!\n", tpath);
 		exit(-1);
 		return;
 	}
 
-	chadfs32_mblk_t mblk;
-	chadfs32_loc_t mblkloc = { 0, (void*)&mblk };
-	status = chadfs32_read_mblk(f, 0, &mblk);
-	if (status != CHADFS_STATUS_OK) PANIC_ERR(status);
-
-	chadfs_sv_t svdirpath = { (char*)indirpath, strlen(indirpath) };
-	status = chadfs32_create_dir(
-		f, &mblkloc, &svdirpath,
-		CHADFS_FILE_ATTRIBUTE_READABLE | CHADFS_FILE_ATTRIBUTE_WRITEABLE
-	);
-	if (status != CHADFS_STATUS_OK) PANIC_ERR(status);
-	
-	fclose(f);
-}
-
-void act_read_txt_file(const char* mpath, const char* infpath, uint32_t offset, uint32_t len) {
-	chadfs_status_t status;
-	FILE* f = fopen(mpath, "rb+");
-	if (!f) {
-		fprintf(stderr, "Failed to open file `%s`!\n", mpath);
+	chadfs_trace_hdr_t hdr;
+	bool v1 = false;
+	if (
+		fread(&hdr, sizeof(hdr), 1, tf) != 1 ||
+		(
+			memcmp(hdr.signature, CHADFS_TRACE_SIGNATURE, sizeof(hdr.signature)) &&
+			!(v1 = !memcmp(hdr.signature, CHADFS_TRACE_SIGNATURE_V1, sizeof(hdr.signature)))
+		)
+	) {
+		fprintf(stderr, "Invalid trace `%s`!\n", tpath);
 		exit(-1);
 		return;
 	}
 
-	chadfs32_mblk_t mblk;
-	chadfs32_loc_t mblkloc = { 0, (void*)&mblk };
-	status = chadfs32_read_mblk(f, 0, &mblk);
-	if (status != CHADFS_STATUS_OK) PANIC_ERR(status);
-
-	chadfs32_eloc_t fblkeloc;
-	chadfs32_eloc_t vblkeloc;
-	chadfs32_fblk_t fblk;
-	chadfs32_vblk_t vblk;
-	chadfs_sv_t svfpath = { (char*)infpath, strlen(infpath) };
-	status = chadfs32_read_fblk(f, &mblkloc, &svfpath, &fblk, &fblkeloc, &vblk, &vblkeloc);
-	if (status != CHADFS_STATUS_OK) PANIC_ERR(status);
+	if (hdr.sectorsize != CHADFS_MIN_SECTOR_SIZE && hdr.sectorsize != CHADFS_MAX_SECTOR_SIZE) {
+		fprintf(stderr, "Unsupported trace sector size (%u)!\n", (unsigned)hdr.sectorsize);
+		exit(-1);
+		return;
+	}
 
-	if (!offset) offset = 0;
-	if (!len) len = fblk.size - offset;
+	fseek(tf, 0, SEEK_END);
+	const size_t recsize = v1 ? sizeof(chadfs_trace_rec_v1_t) : sizeof(chadfs_trace_rec_t);
+	size_t numrecs = ((size_t)ftell(tf) - sizeof(hdr)) / recsize;
+	fseek(tf, sizeof(hdr), SEEK_SET);
 
-	char* data = (char*)malloc(len);
-	if (!data) {
+	chadfs_trace_rec_t* recs = (chadfs_trace_rec_t*)malloc(numrecs * sizeof(chadfs_trace_rec_t) + 1);
+	if (!recs) {
 		fprintf(stderr, "Not enough memory!\n");
 		exit(-1);
 		return;
 	}
 
-	status = chadfs32_read_file(f, &mblkloc, &svfpath, data, offset, len);
-	if (status != CHADFS_STATUS_OK) PANIC_ERR(status);
-
-	for (size_t i = 0; i < len; ++i) putchar(data[i]);
-
-	free(data);
-	fclose(f);
-}
-
-void act_read_bin_file(const char* mpath, const char* infpath, uint32_t offset, uint32_t len) {
-	chadfs_status_t status;
-	FILE* f = fopen(mpath, "rb+");
-	if (!f) {
-		fprintf(stderr, "Failed to open file `%s`!\n", mpath);
+	if (numrecs && fread(recs, recsize, numrecs, tf) != numrecs) {
+		fprintf(stderr, "Failed to read file `%s`!\n", tpath);
 		exit(-1);
 		return;
 	}
 
-	chadfs32_mblk_t mblk;
-	chadfs32_loc_t mblkloc = { 0, (void*)&mblk };
-	status = chadfs32_read_mblk(f, 0, &mblk);
-	if (status != CHADFS_STATUS_OK) PANIC_ERR(status);
-
-	chadfs32_eloc_t fblkeloc;
-	chadfs32_eloc_t vblkeloc;
-	chadfs32_fblk_t fblk;
-	chadfs32_vblk_t vblk;
-	chadfs_sv_t svfpath = { (char*)infpath, strlen(infpath) };
-	status = chadfs32_read_fblk(f, &mblkloc, &svfpath, &fblk, &fblkeloc, &vblk, &vblkeloc);
-	if (status != CHADFS_STATUS_OK) PANIC_ERR(status);
+	/* widen old records in place, from the last (they are smaller) */
+	for (size_t j = v1 ? numrecs : 0; j; --j) {
+		chadfs_trace_rec_v1_t old;
+		memcpy(&old, (uint8_t*)recs + (j - 1) * recsize, sizeof(old));
+		memset(&recs[j - 1], 0, sizeof(recs[j - 1]));
+		recs[j - 1].type = old.type;
+		recs[j - 1].op = old.op;
+		recs[j - 1].address = ((uint64_t)old.addresshi << 32) | old.address;
+		recs[j - 1].time = old.time;
+	}
 
-	if (!offset) offset = 0;
-	if (!len) len = fblk.size - offset;
+	fclose(tf);
 
-	uint8_t* data = (uint8_t*)malloc(len);
-	if (!data) {
-		fprintf(stderr, "Not enough memory!\n");
-		exit(-1);
-		return;
+	char* nocache = "0";
+	if (!numcaches) {
+		numcaches = 1;
+		caches = &nocache;
 	}
 
-	status = chadfs32_read_file(f, &mblkloc, &svfpath, data, offset, len);
-	if (status != CHADFS_STATUS_OK) PANIC_ERR(status);
+	printf(
+		"%-12s %10s %10s %10s %10s %10s %10s %10s %12s\n",
+		"cache", "accesses", "reads", "writes", "hits", "misses", "breads", "bwrites", "time(us)"
+	);
 
-	if (len) {
-		size_t i = 0;
-		for (; i < len - 1; ++i) printf("%02x ", (unsigned)data[i]);
-		printf("%02x", (unsigned)data[i]);
+	uint8_t sector[CHADFS_MAX_SECTOR_SIZE];
+	memset(sector, 0, sizeof(sector));
+	for (int i = 0; i < numcaches; ++i) {
+		uint32_t cachesectors = (uint32_t)strtoul(caches[i], NULL, 10);
+
+		ut_dev_t dev;
+		if (!strcmp(mpath, "-ram")) ut_dev_init_ram(&dev, hdr.sectorsize, cachesectors);
+		else {
+			FILE* f = fopen(mpath, "rb+");
+			if (!f) {
+				fprintf(stderr, "Failed to open file `%s`!\n", mpath);
+				exit(-1);
+				return;
+			}
+
+			ut_dev_init_file(&dev, f, hdr.sectorsize, cachesectors);
+		}
+
+		size_t numreads = 0;
+		uint64_t start = host_clock();
+		for (size_t j = 0; j < numrecs; ++j) {
+			if (recs[j].type == CHADFS_TRACE_WRITE) chadfs64_write_sector(&dev, recs[j].address, sector);
+			else {
+				chadfs64_read_sector(&dev, recs[j].address, sector);
+				numreads += 1;
+			}
+		}
+
+		ut_dev_flush(&dev);
+		uint64_t elapsed = host_clock() - start;
+
+		printf(
+			"%-12u %10llu %10llu %10llu %10llu %10llu %10llu %10llu %12llu\n",
+			(unsigned)cachesectors,
+			(unsigned long long)numrecs,
+			(unsigned long long)numreads,
+			(unsigned long long)(numrecs - numreads),
+			(unsigned long long)dev.hits,
+			(unsigned long long)dev.misses,
+			(unsigned long long)dev.breads,
+			(unsigned long long)dev.bwrites,
+			(unsigned long long)(elapsed / 1000)
+		);
+
+		ut_dev_close(&dev);
 	}
 
-	free(data);
-	fclose(f);
+	free(recs);
 }
 
-void act_trunc_file(const char* mpath, const char* fpath, uint32_t len) {
+/* ========================================= */
+
+void open_img(ut_img_t* img, const char* mpath) {
 	chadfs_status_t status;
 	FILE* f = fopen(mpath, "rb+");
 	if (!f) {
@@ -467,110 +767,154 @@ void act_trunc_file(const char* mpath, const char* fpath, uint32_t len) {
 		return;
 	}
 
-	chadfs32_mblk_t mblk;
-	chadfs32_loc_t mblkloc = { 0, (void*)&mblk };
-	status = chadfs32_read_mblk(f, 0, &mblk);
-	if (status != CHADFS_STATUS_OK) PANIC_ERR(status);
-
-	chadfs_sv_t svfpath = { (char*)fpath, strlen(fpath) };
-	status = chadfs32_trunc_file(f, &mblkloc, &svfpath, len);
-	if (status != CHADFS_STATUS_OK) PANIC_ERR(status);
-
-	fclose(f);
-}
+	/* the mblk fits the first 512 bytes, the sector size is known after reading it */
+	ut_dev_init_file(&img->dev, f, CHADFS_MIN_SECTOR_SIZE, cachesectors);
+	img->mblkloc32.a = 0;
+	img->mblkloc32.d = &img->mblk32;
+	img->mblkloc64.a = 0;
+	img->mblkloc64.d = &img->mblk64;
 
-void act_remove_file(const char* mpath, const char* fpath) {
-	chadfs_status_t status;
-	FILE* f = fopen(mpath, "rb+");
-	if (!f) {
-		fprintf(stderr, "Failed to open file `%s`!\n", mpath);
-		exit(-1);
-		return;
+	/* both widths share the signature, the version byte tells them apart */
+	img->version = CHADFS_VERSION32;
+	status = chadfs32_read_mblk(&img->dev, 0, &img->mblk32);
+	if (status == CHADFS_STATUS_INVALID_MBLK) {
+		img->version = CHADFS_VERSION64;
+		status = chadfs64_read_mblk(&img->dev, 0, &img->mblk64);
 	}
 
-	chadfs32_mblk_t mblk;
-	chadfs32_loc_t mblkloc = { 0, (void*)&mblk };
-	status = chadfs32_read_mblk(f, 0, &mblk);
 	if (status != CHADFS_STATUS_OK) PANIC_ERR(status);
 
-	chadfs_sv_t svfpath = { (char*)fpath, strlen(fpath) };
-	status = chadfs32_remove_file(f, &mblkloc, &svfpath);
+	img->delaybytes = delaybytes;
+	img->attributes = fileattrs;
+	img->dedup = dedup;
+	img->volflags = volflags;
+	img->sectorsize = CHADFS_SECTOR_SIZE_OF(img->version == CHADFS_VERSION64 ? img->mblk64.sectorshift : img->mblk32.sectorshift);
+	ut_dev_set_sector_size(&img->dev, img->sectorsize);
+	set_trace_sector_size(img->sectorsize);
+
+	/* freed data becomes holes, so the image tracks live data */
+	chadfs_set_discarder(&discarder);
+
+	/* records left by an interrupted commit */
+	if (img->version == CHADFS_VERSION64) status = chadfs64_replay_journals(&img->dev, &img->mblkloc64);
+	else status = chadfs32_replay_journals(&img->dev, &img->mblkloc32);
 	if (status != CHADFS_STATUS_OK) PANIC_ERR(status);
 
-	fclose(f);
-}
+	if (jvolume) {
+		jbuffer = malloc(UT_JOURNAL_BUFFER);
+		if (!jbuffer) {
+			fprintf(stderr, "Not enough memory!\n");
+			exit(-1);
+		}
 
-void act_write_file(const char* mpath, const char* infpath, const char* extfpath, uint32_t offset) {
-	chadfs_status_t status;
-	FILE* f = fopen(mpath, "rb+");
-	if (!f) {
-		fprintf(stderr, "Failed to open file `%s`!\n", mpath);
-		exit(-1);
-		return;
+		journal.flush = ut_dev_sync;
+		if (img->version == CHADFS_VERSION64) ut64_begin_journal(img, jvolume, &journal, jbuffer, UT_JOURNAL_BUFFER);
+		else ut32_begin_journal(img, jvolume, &journal, jbuffer, UT_JOURNAL_BUFFER);
 	}
 
-	chadfs32_mblk_t mblk;
-	chadfs32_loc_t mblkloc = { 0, (void*)&mblk };
-	status = chadfs32_read_mblk(f, 0, &mblk);
-	if (status != CHADFS_STATUS_OK) PANIC_ERR(status);
+	/* flush on exit(...) too, so actions done before an error are kept */
+	curimg = img;
+	curimgpath = mpath;
+	atexit(close_img);
+}
 
-	FILE* extf = fopen(extfpath, "rb");
-	if (!extf) {
-		fprintf(stderr, "Failed to open file `%s`!\n", extfpath);
-		exit(-1);
-		return;
-	}
+void close_img(void) {
+	if (!curimg) return;
 
-	fseek(extf, 0, SEEK_END);
-	size_t extflen = (size_t)ftell(extf);
-	fseek(extf, 0, SEEK_SET);
+	if (jbuffer) {
+		chadfs_status_t status;
+		if (journal.version == CHADFS_VERSION64) status = chadfs64_end_journal(&journal);
+		else status = chadfs32_end_journal(&journal);
+		if (status != CHADFS_STATUS_OK) fprintf(stderr, "Error: `%s` (journal)!\n", chadfs_status_to_str(status));
 
-	uint8_t* extfdata = (uint8_t*)malloc(extflen);
-	if (!extfdata) {
-		fprintf(stderr, "Not enough memory!\n");
-		exit(-1);
-		return;
+		free(jbuffer);
+		jbuffer = NULL;
 	}
 
-	if (fread(extfdata, extflen, 1, extf) != 1) {
-		fprintf(stderr, "Failed to read file `%s`!\n", extfpath);
-		exit(-1);
-		return;
-	}
+	ut_dev_close(&curimg->dev);
+	curimg = NULL;
+}
 
-	chadfs_sv_t svinfpath = { (char*)infpath, strlen(infpath) };
-	status = chadfs32_write_file(f, &mblkloc, &svinfpath, extfdata, offset, (uint32_t)extflen);
-	if (status != CHADFS_STATUS_OK) PANIC_ERR(status);
+uint64_t host_clock(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000U + (uint64_t)ts.tv_nsec;
+}
 
-	free(extfdata);
-	fclose(extf);
-	fclose(f);
+void print_stats(void) {
+	fprintf(
+		stderr, "\n%-20s %8s %10s %10s %10s %10s %12s %12s\n",
+		"op", "calls", "sreads", "swrites", "chits", "cmisses", "bytes", "time(us)"
+	);
+
+	for (size_t i = 0; i < CHADFS_NUMOF_OPS; ++i) {
+		const chadfs_opstats_t* ops = &stats.ops[i];
+		if (!ops->calls && !ops->sreads && !ops->swrites) continue;
+
+		fprintf(
+			stderr, "%-20s %8llu %10llu %10llu %10llu %10llu %12llu %12llu\n",
+			chadfs_op_to_str((chadfs_op_t)i),
+			(unsigned long long)ops->calls,
+			(unsigned long long)ops->sreads,
+			(unsigned long long)ops->swrites,
+			(unsigned long long)ops->chits,
+			(unsigned long long)ops->cmisses,
+			(unsigned long long)ops->bytes,
+			(unsigned long long)(ops->time / 1000)
+		);
+	}
 }
 
 /* ========================================= */
 
-void chadfs32_write_sector(void* dev, uint32_t address, const void* sectordata) {
-	if (fseek((FILE*)dev, (long)(address << 9), SEEK_SET)) {
-		fprintf(stderr, "fseek(...) != 0 (lba=0x%x)!\n", (unsigned)address);
+void trace_emit(void* ctx, const chadfs_trace_rec_t* rec) {
+	if (fwrite(rec, sizeof(*rec), 1, (FILE*)ctx) != 1) {
+		fprintf(stderr, "Failed to write trace!\n");
 		exit(-1);
-		return;
 	}
+}
 
-	if (fwrite(sectordata, CHADFS_SECTOR_SIZE, 1, (FILE*)dev) != 1) {
-		fprintf(stderr, "fwrite(...) != 1 (lba=0x%x)!\n", (unsigned)address);
+void open_trace(const char* tpath) {
+	FILE* tf = fopen(tpath, "wb");
+	if (!tf) {
+		fprintf(stderr, "Failed to create file `%s`!\n", tpath);
 		exit(-1);
 	}
-}
 
-void chadfs32_read_sector(void* dev, uint32_t address, void* sectordata) {
-	if (fseek((FILE*)dev, (long)(address << 9), SEEK_SET)) {
-		fprintf(stderr, "fseek(...) != 0 (lba=0x%x)!\n", (unsigned)address);
+	chadfs_trace_hdr_t hdr;
+	memset(&hdr, 0, sizeof(hdr));
+	memcpy(hdr.signature, CHADFS_TRACE_SIGNATURE, sizeof(hdr.signature));
+	hdr.sectorsize = CHADFS_MIN_SECTOR_SIZE;
+	if (fwrite(&hdr, sizeof(hdr), 1, tf) != 1) {
+		fprintf(stderr, "Failed to write data to file `%s`!\n", tpath);
 		exit(-1);
-		return;
 	}
 
-	if (fread(sectordata, CHADFS_SECTOR_SIZE, 1, (FILE*)dev) != 1) {
-		fprintf(stderr, "fread(...) != 1 (lba=0x%x)!\n", (unsigned)address);
+	tracer.emit = trace_emit;
+	tracer.ctx = tf;
+	tracer.clock = host_clock;
+	chadfs_set_tracer(&tracer);
+	atexit(close_trace);
+}
+
+/*
+	Record the sector size of the traced image (open_img)
+*/
+void set_trace_sector_size(uint32_t sectorsize) {
+	if (!chadfs_get_tracer()) return;
+
+	FILE* tf = (FILE*)tracer.ctx;
+	long end = ftell(tf);
+	fseek(tf, (long)offsetof(chadfs_trace_hdr_t, sectorsize), SEEK_SET);
+	if (fwrite(&sectorsize, sizeof(sectorsize), 1, tf) != 1) {
+		fprintf(stderr, "Failed to write trace!\n");
 		exit(-1);
 	}
-}
\ No newline at end of file
+
+	fseek(tf, end, SEEK_SET);
+}
+
+void close_trace(void) {
+	chadfs_set_tracer(NULL);
+	fclose((FILE*)tracer.ctx);
+}
@@ -0,0 +1,83 @@
+#ifndef UT_H
+#define UT_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <chadfs.h>
+#include "dev.h"
+
+#define PANIC_ERR(__status) {\
+	fprintf(stderr, "Error: `%s`!\n", chadfs_status_to_str(__status));\
+	exit(-1);\
+	return;\
+}
+
+#define UT_DEFAULT_CACHE_SECTORS						8192U
+#define UT_MAX_BATCH_ARGS								16
+#define UT_IMPORT_CHUNK									0x10000U
+#define UT_EXPORT_CHUNK									0x400000U
+#define UT_EXPORT_CACHE_SECTORS							1024U
+#define UT_MAX_EXPORT_THREADS							64U
+#define UT_JOURNAL_BUFFER								0x100000U
+#define UT_BATCH_BUFFER									0x800000U
+#define UT_BENCH_READ									0x1000U
+#define UT_BENCH_SCAN_ENTRIES							0x4000U
+#define UT_BENCH_SCAN_PASSES							1024U
+
+/* Opened CHADFS image */
+typedef struct _ut_img_t {
+	ut_dev_t			dev;
+	uint8_t				version;						/* CHADFS_VERSION32/CHADFS_VERSION64 */
+	uint32_t			sectorsize;						/* from mblk.sectorshift */
+	size_t				delaybytes;						/* delayed allocation buffer of writers (0 - none) */
+	uint32_t			attributes;						/* added to created files (CHADFS_FILE_ATTRIBUTE_COMPRESSED) */
+	bool				dedup;							/* imported files equal to one before and copies share data */
+	uint8_t				volflags;						/* added to new volumes (CHADFS_VOLUME_WIDE_IDS) */
+	union {
+		chadfs32_mblk_t	mblk32;
+		chadfs64_mblk_t	mblk64;
+	};
+	chadfs32_loc_t		mblkloc32;
+	chadfs64_loc_t		mblkloc64;
+} ut_img_t;
+
+/* Host tree entry (see act_import_tree) */
+typedef struct _ut_tentry_t {
+	char*				hpath;							/* host path */
+	char*				ipath;							/* path inside image */
+	bool				dir;
+	uint64_t			size;							/* file size or num of dir entries */
+} ut_tentry_t;
+
+/* Fingerprint index slot (see act_import_tree) */
+typedef struct _ut_fprint_t {
+	uint64_t			size;
+	uint32_t			hash;							/* see hash_host_file */
+	size_t				ientry;							/* tree entry of the first file with them + 1 (0 - free slot) */
+} ut_fprint_t;
+
+/*
+	Image actions are written once (act.inc) and compiled per format
+	width by act32.c/act64.c, e.g. UT_N(run_action) - ut32_run_action,
+	UT_W(mblkloc) - mblkloc32
+*/
+#define UT_N(__name)									CHADFS_XCAT(ut, CHADFS_W, _##__name)
+#define UT_W(__name)									CHADFS_XCAT(__name, CHADFS_W, )
+
+extern const char* curimgpath;
+
+bool ut32_run_action(ut_img_t* img, int argc, char** argv);
+bool ut64_run_action(ut_img_t* img, int argc, char** argv);
+void ut32_begin_journal(ut_img_t* img, const char* name, chadfs_journal_t* journal, void* buffer, size_t size);
+void ut64_begin_journal(ut_img_t* img, const char* name, chadfs_journal_t* journal, void* buffer, size_t size);
+
+uint8_t* alloc_chunk(void);
+uint64_t host_clock(void);
+char* join_path(const char* a, const char* b);
+ut_tentry_t* plan_tree(const char* hdirpath, const char* indirpath, uint64_t maxsize, size_t* numentries);
+void make_host_dir(const char* hpath);
+uint32_t hash_host_file(const char* hpath, uint8_t* chunk);
+bool same_host_files(const char* apath, const char* bpath, uint8_t* chunk);
+
+#endif